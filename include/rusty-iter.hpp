@@ -140,6 +140,18 @@
 #include <type_traits>
 #include <optional>
 #include <utility>
+#include <vector>
+#include <string>
+#include <array>
+#include <iterator>
+#include <functional>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <limits>
 
 namespace rusty
 {
@@ -193,6 +205,423 @@ namespace rusty
             }
         }
 
+        // Finds the minimum and the maximum of contiguous arithmetic values (size must be at least 1).
+        // The loop is branchless, so that the compiler can vectorize it.
+        template <typename T>
+        void minmax_contiguous(const T* data, size_t size, T& minValue, T& maxValue)
+        {
+            T currentMin = data[0];
+            T currentMax = data[0];
+            for (size_t i = 1; i < size; ++i)
+            {
+                T value = data[i];
+                currentMin = value < currentMin ? value : currentMin;
+                currentMax = value > currentMax ? value : currentMax;
+            }
+
+            minValue = currentMin;
+            maxValue = currentMax;
+        }
+
+        // Finds the index of the first minimum (or maximum, if FindMax is true) of contiguous arithmetic values (size must be at least 1).
+        // The extreme value is found first with a branchless loop which the compiler can vectorize,
+        // then the index of its first occurrence is searched.
+        template <bool FindMax, typename T>
+        size_t position_extreme_contiguous(const T* data, size_t size)
+        {
+            T extreme = data[0];
+            for (size_t i = 1; i < size; ++i)
+            {
+                T value = data[i];
+                if constexpr (FindMax)
+                {
+                    extreme = value > extreme ? value : extreme;
+                }
+                else
+                {
+                    extreme = value < extreme ? value : extreme;
+                }
+            }
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (data[i] == extreme)
+                {
+                    return i;
+                }
+            }
+
+            // the first value is NaN, which is never replaced
+            return 0;
+        }
+
+        // Rearranges the values in [begin, end), so that the values at the given sorted indices (which must be in that range)
+        // are the same as they would be if all values were sorted.
+        // The range is partitioned around the middle index, then both halves are processed recursively with the remaining indices,
+        // so selecting m indices takes O(n * log(m)) time, instead of O(n * log(n)) for a full sort.
+        template <typename T, typename Less>
+        void select_multiple(T* data, size_t begin, size_t end, const size_t* indices, size_t indexCount, const Less& less)
+        {
+            if (indexCount == 0)
+            {
+                return;
+            }
+
+            size_t middle = indexCount / 2;
+            size_t index = indices[middle];
+            std::nth_element(data + begin, data + index, data + end, less);
+
+            select_multiple(data, begin, index, indices, middle, less);
+            select_multiple(data, index + 1, end, indices + middle + 1, indexCount - middle - 1, less);
+        }
+
+        // Restores the max-heap property of the values in [0, size) (as created by std::make_heap with the same comparer),
+        // after the value at the root was replaced, by moving the root down until it's not less than its children.
+        // The value is moved into a hole, so there is only one move per level, instead of a swap.
+        template <typename T, typename Less>
+        void sift_down_root(T* data, size_t size, const Less& less)
+        {
+            T value = std::move(data[0]);
+            size_t hole = 0;
+            while (true)
+            {
+                size_t child = hole * 2 + 1;
+                if (child >= size)
+                {
+                    break;
+                }
+
+                if (child + 1 < size && less(data[child], data[child + 1]))
+                {
+                    ++child;
+                }
+
+                if (!less(value, data[child]))
+                {
+                    break;
+                }
+
+                data[hole] = std::move(data[child]);
+                hole = child;
+            }
+
+            data[hole] = std::move(value);
+        }
+
+        // Clamps a quantile to [0, 1], so that it can be converted to an index. NaN is treated as 0.
+        inline double clamp_quantile(double quantile)
+        {
+            return quantile > 0.0 ? (quantile < 1.0 ? quantile : 1.0) : 0.0;
+        }
+
+        // Returns the number of leading values for which the predicate returns true (the values must be partitioned by it).
+        // This is a branchless binary search: the range is halved in every step, and the new start is selected with a conditional move
+        // instead of a branch, so there are no branch mispredictions, and the number of steps only depends on the size.
+        template <typename T, typename Predicate>
+        size_t partition_point_contiguous(const T* data, size_t size, const Predicate& predicate)
+        {
+            if (size == 0)
+            {
+                return 0;
+            }
+
+            const T* base = data;
+            while (size > 1)
+            {
+                size_t half = size / 2;
+                base = predicate(base[half]) ? base + half : base;
+                size -= half;
+            }
+
+            return static_cast<size_t>(base - data) + (predicate(*base) ? 1 : 0);
+        }
+
+        // Helper class which compares two values with the `compare` function when used as a functor.
+        struct Comparison
+        {
+            template <typename T>
+            char operator()(const T& a, const T& b) const
+            {
+                return compare(a, b);
+            }
+        };
+
+        // Helper class which compares two values with the == operator when used as a functor.
+        struct Equality
+        {
+            template <typename T>
+            bool operator()(const T& a, const T& b) const
+            {
+                return a == b;
+            }
+        };
+
+        // Helper class which returns its parameter when used as a functor.
+        struct Identity
+        {
+            template <typename T>
+            const T& operator()(const T& value) const
+            {
+                return value;
+            }
+        };
+
+        // Empty type, used as the value type of hash tables that only store keys.
+        struct Empty
+        {
+        };
+
+        // Scrambles the bits of a hash value, so that all bits of the result depend on all bits of the input.
+        // This is needed because std::hash is the identity function for integers on most platforms,
+        // which would cause lots of collisions in power of two sized hash tables.
+        inline std::uint64_t mix_hash64(std::uint64_t x)
+        {
+            // splitmix64 finalizer
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return x;
+        }
+
+        inline size_t mix_hash(size_t hash)
+        {
+            return static_cast<size_t>(mix_hash64(static_cast<std::uint64_t>(hash)));
+        }
+
+        // Returns a * b, or the maximum value of size_t if the result doesn't fit in it.
+        inline size_t saturating_mul(size_t a, size_t b)
+        {
+            return b != 0 && a > std::numeric_limits<size_t>::max() / b ? std::numeric_limits<size_t>::max() : a * b;
+        }
+
+        // Returns the number of leading zero bits of a 64-bit value (64 for 0).
+        inline unsigned leading_zeros64(std::uint64_t x)
+        {
+            if (x == 0)
+            {
+                return 64;
+            }
+
+            unsigned count = 0;
+            for (unsigned shift = 32; shift > 0; shift /= 2)
+            {
+                if ((x >> (64 - shift)) == 0)
+                {
+                    count += shift;
+                    x <<= shift;
+                }
+            }
+
+            return count;
+        }
+
+        // Open addressing hash table with linear probing.
+        // The capacity is always a power of two, and the table grows when it becomes more than 3/4 full.
+        template <typename Key, typename Value, typename Hash = std::hash<Key>>
+        struct HashTable
+        {
+            using Entry = std::pair<Key, Value>;
+
+            HashTable() : _slots(), _size(0)
+            {
+            }
+
+            size_t size() const
+            {
+                return _size;
+            }
+
+            // Makes sure that at least `count` entries can be inserted without growing the table.
+            void reserve(size_t count)
+            {
+                size_t capacity = 8;
+                while (capacity / 4 * 3 < count)
+                {
+                    capacity *= 2;
+                }
+
+                if (capacity > _slots.size())
+                {
+                    rehash(capacity);
+                }
+            }
+
+            // Returns a pointer to the value of the given key, or null if the key is not in the table.
+            Value* find(const Key& key)
+            {
+                if (_slots.empty())
+                {
+                    return nullptr;
+                }
+
+                size_t mask = _slots.size() - 1;
+                for (size_t i = index_of(key); ; i = (i + 1) & mask)
+                {
+                    std::optional<Entry>& slot = _slots[i];
+                    if (!slot)
+                    {
+                        return nullptr;
+                    }
+
+                    if (slot->first == key)
+                    {
+                        return &slot->second;
+                    }
+                }
+            }
+
+            const Value* find(const Key& key) const
+            {
+                return const_cast<HashTable*>(this)->find(key);
+            }
+
+            // Inserts the given key with the given value, if the key is not in the table yet.
+            // Returns a pointer to the value of the key, and true if the key was inserted, or false if it was already in the table.
+            std::pair<Value*, bool> insert(const Key& key, const Value& value)
+            {
+                if (_size + 1 > _slots.size() / 4 * 3)
+                {
+                    rehash(_slots.empty() ? 8 : _slots.size() * 2);
+                }
+
+                size_t mask = _slots.size() - 1;
+                for (size_t i = index_of(key); ; i = (i + 1) & mask)
+                {
+                    std::optional<Entry>& slot = _slots[i];
+                    if (!slot)
+                    {
+                        slot.emplace(key, value);
+                        ++_size;
+                        return { &slot->second, true };
+                    }
+
+                    if (slot->first == key)
+                    {
+                        return { &slot->second, false };
+                    }
+                }
+            }
+
+            // Same as `insert`, but the table never grows, and at most `maxProbes` slots are checked.
+            // If the key is not found in those slots, and none of them are empty, then the entry in the first checked slot is replaced.
+            // This way the memory usage stays constant, but some keys might be forgotten.
+            // The table must have a non-zero capacity (see `reserve`).
+            std::pair<Value*, bool> insert_bounded(const Key& key, const Value& value, size_t maxProbes)
+            {
+                size_t mask = _slots.size() - 1;
+                size_t first = index_of(key);
+                for (size_t probe = 0, i = first; probe < maxProbes && probe <= mask; ++probe, i = (i + 1) & mask)
+                {
+                    std::optional<Entry>& slot = _slots[i];
+                    if (!slot)
+                    {
+                        slot.emplace(key, value);
+                        ++_size;
+                        return { &slot->second, true };
+                    }
+
+                    if (slot->first == key)
+                    {
+                        return { &slot->second, false };
+                    }
+                }
+
+                // the slot stays occupied, so the probe sequences of the other keys are not affected, only the replaced key is forgotten
+                _slots[first].emplace(key, value);
+                return { &_slots[first]->second, true };
+            }
+
+            // Removes the given key from the table. Returns true if the key was in the table.
+            // The entries after the removed one are shifted back if needed, so no tombstones are left in the table.
+            bool erase(const Key& key)
+            {
+                if (_slots.empty())
+                {
+                    return false;
+                }
+
+                size_t mask = _slots.size() - 1;
+                size_t hole = index_of(key);
+                while (true)
+                {
+                    if (!_slots[hole])
+                    {
+                        return false;
+                    }
+
+                    if (_slots[hole]->first == key)
+                    {
+                        break;
+                    }
+
+                    hole = (hole + 1) & mask;
+                }
+
+                _slots[hole].reset();
+                --_size;
+
+                for (size_t i = (hole + 1) & mask; _slots[i]; i = (i + 1) & mask)
+                {
+                    // the entry can be moved into the hole, if its ideal slot is not between the hole and its current slot
+                    size_t ideal = index_of(_slots[i]->first);
+                    bool idealAfterHole = hole < i ? (ideal > hole && ideal <= i) : (ideal > hole || ideal <= i);
+                    if (!idealAfterHole)
+                    {
+                        _slots[hole] = std::move(_slots[i]);
+                        _slots[i].reset();
+                        hole = i;
+                    }
+                }
+
+                return true;
+            }
+
+            // Calls the provided callback with each key and value in the table, in an unspecified order.
+            template <typename Callback>
+            void for_each(const Callback& callback) const
+            {
+                for (const std::optional<Entry>& slot : _slots)
+                {
+                    if (slot)
+                    {
+                        callback(slot->first, slot->second);
+                    }
+                }
+            }
+
+        private:
+            size_t index_of(const Key& key) const
+            {
+                return mix_hash(Hash()(key)) & (_slots.size() - 1);
+            }
+
+            void rehash(size_t capacity)
+            {
+                std::vector<std::optional<Entry>> oldSlots(capacity);
+                oldSlots.swap(_slots);
+
+                size_t mask = capacity - 1;
+                for (std::optional<Entry>& slot : oldSlots)
+                {
+                    if (slot)
+                    {
+                        size_t i = index_of(slot->first);
+                        while (_slots[i])
+                        {
+                            i = (i + 1) & mask;
+                        }
+
+                        _slots[i].emplace(std::move(*slot));
+                    }
+                }
+            }
+
+            std::vector<std::optional<Entry>> _slots;
+            size_t _size;
+        };
+
         template <typename Collection, typename T>
         static void add_to_collection(Collection& collection, const T& value)
         {
@@ -464,10 +893,12 @@ namespace rusty
             using type = void;
         };
 
+        // For pointers, the const qualifier is removed from the value type (same as for std::iterator_traits<const T*>::value_type),
+        // so iterators over const elements (e.g. slices) yield `const T*`, and consumers like `sum` or `min` can store a copy
         template <class T, class U = void>
         struct ValueTypeHelper
         {
-            using value_type = typename std::remove_pointer_t<T>;
+            using value_type = typename std::remove_cv_t<std::remove_pointer_t<T>>;
         };
 
         template <class T>
@@ -529,1589 +960,6044 @@ namespace rusty
         template <typename GeneratorFunction>
         struct FiniteGeneratorIter;
 
+        template <typename GeneratorFunction>
+        struct DoubleEndedFiniteGeneratorIter;
+
         template <typename T>
         struct EmptyIter;
 
         template <typename IterType>
         struct ReverseIter;
-    }
 
+        template <typename IterType, bool Exact>
+        struct ChunksIter;
 
-    //
-    // Iterator base class
-    //
+        template <typename IterType>
+        struct WindowsIter;
 
-    // Forward declaration
-    template <typename ConcreteIterType, typename OutType>
-    struct DoubleEndedIterator;
+        template <typename IterType, typename SumType, bool Mean>
+        struct RollingSumIter;
 
-    // Base class for all iterators.
-    template <typename ConcreteIterType, typename OutType>
-    struct Iterator
-    {
-        friend struct DoubleEndedIterator<ConcreteIterType, OutType>;
+        template <typename IterType, bool Max>
+        struct RollingExtremeIter;
 
-        Iterator() = default;
-        Iterator(const Iterator&) = default;
-        Iterator& operator=(const Iterator&) = default;
+        template <typename IterType, size_t N>
+        struct ArrayChunksIter;
 
-        // Advances the iterator, and returns a pointer to the next value.
-        // Returns null if there are no more elements left in the iterator.
-        // The returned pointer becomes invalid if the iterator goes out of scope,
-        // or if the iterator is advanced again (by calling next()).
-        inline const OutType* next()
-        {
-            return concrete_iter()->next_impl();
-        }
+        template <typename IterType, typename KeyFunction>
+        struct ChunkByIter;
 
-        //
-        // Consumer functions
-        //
+        template <typename IterType, typename KeyFunction, typename EqualityFunction>
+        struct DedupIter;
 
-        // Calls the provided callback on all remaining elements of the iterator.
-        template <typename Callback>
-        void for_each(const Callback& callback)
-        {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Callback, const OutType&>::check();
+        template <typename IterType, typename KeyFunction, bool Bounded>
+        struct UniqueIter;
 
-            while (const OutType* value = next())
-            {
-                callback(*value);
-            }
-        }
+        template <typename IterType, typename MapWhileFunction>
+        struct MapWhileIter;
 
-        // Transforms the iterator into a collection, e.g. an std::vector, std::string, std::set, etc.
-        template <typename Collection>
-        Collection collect()
-        {
-            Collection coll{ };
-            while (const OutType* value = next())
-            {
-                detail::add_to_collection(coll, *value);
-            }
+        template <typename IterType>
+        struct FuseIter;
 
-            return coll;
-        }
+        template <typename IterType, typename OtherIterType, typename Comparer>
+        struct MergeIter;
 
-        // Same as collect, but calls `reserve` on the collection before adding any elements to it.
-        template <typename Collection, typename SizeType = size_t>
-        Collection collect_with_size_hint(const SizeType& sizeHint)
-        {
-            Collection coll{ };
-            coll.reserve(sizeHint);
+        template <typename IterType, typename Comparer>
+        struct KMergeIter;
 
-            while (const OutType* value = next())
-            {
-                detail::add_to_collection(coll, *value);
-            }
+        template <typename IterType, typename OtherIterType>
+        struct InterleaveIter;
 
-            return coll;
-        }
+        template <typename IterType>
+        struct RoundRobinIter;
 
-        // Partitions the elements of the iterator based on the provided predicate callback.
-        // This function creates two collections - the first collection will contain all values which
-        // the predicate returned false for, the second will contain the rest (which the predicate returned true for).
-        template <typename Collection, typename Predicate>
-        std::pair<Collection, Collection> partition(const Predicate& predicate)
+        template <typename IterType, typename OtherIterType, typename KeyFunction, typename OtherKeyFunction>
+        struct HashJoinIter;
+
+        template <typename IterType, typename OtherIterType, typename Comparer>
+        struct MergeJoinIter;
+
+        enum class SetOperation
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+            Intersection,
+            Union,
+            Difference,
+            SymmetricDifference,
+        };
 
-            std::pair<Collection, Collection> result = { };
-            Collection* collections[2] = { &result.first, &result.second };
+        template <typename IterType, typename OtherIterType, typename Comparer, SetOperation Operation>
+        struct SetOperationIter;
 
-            for_each([&](const OutType& value)
-            {
-                detail::add_to_collection(*collections[predicate(value)], value);
-            });
+        template <typename IterType, typename Comparer>
+        struct SortedLazyIter;
 
-            return result;
-        }
+        template <typename IterType, typename OtherIterType>
+        struct CartesianProductIter;
 
-        // Reduces the iterator into a single value, by repeatedly calling the provided reducer function.
-        // The reducer function takes two parameters:
-        // The first parameter is the accumulator, which will contain the last value returned by the reducer function.
-        // (when it's first called, it will be the first element of the iterator)
-        // The second parameter is the current element of the iterator.
-        // The reducer function must return a value, which will be passed as the first parameter to the reducer function,
-        // or, for the last element, this value will be the result of the entire reduce operation.
-        // For empty iterators, an empty value is returned. In all other cases, a non-empty value will be returned.
-        template <typename ReduceFunction>
-        std::optional<OutType> reduce(const ReduceFunction& reduceFunction)
-        {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<ReduceFunction, const OutType&, const OutType&>::check();
+        template <typename IterType>
+        struct CombinationsIter;
 
-            const OutType* first = next();
-            if (!first)
-            {
-                // no elements, return an empty value
-                return { };
-            }
+        template <typename IterType>
+        struct PermutationsIter;
 
-            OutType reduced = *first;
-            while (const OutType* value = next())
-            {
-                const OutType& reducedConst = reduced;
-                reduced = reduceFunction(reducedConst, *value);
-            }
+        template <typename IterType, size_t N>
+        struct TeeIter;
 
-            return reduced;
-        }
 
-        // Similarly to `reduce`, this function also reduces the iterator to a single value,
-        // the difference is that `fold` takes an initial value, instead of using the first value in the iterator.
-        // Because of this, `fold` will always return a value. (If the iterator is empty, then the initial value is returned)
-        template <typename T, typename FoldFunction>
-        T fold(T initialValue, const FoldFunction& foldFunction)
-        {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<FoldFunction, const T&, const OutType&>::check();
+        //
+        // Traits
+        //
 
-            while (const OutType* value = next())
-            {
-                const T& currentValue = initialValue;
-                initialValue = foldFunction(currentValue, *value);
-            }
+        // Checks if a C++ iterator points to elements that are stored contiguously in memory.
+        // This is true for pointers, and for the iterators of std::vector and std::basic_string.
+        template <typename CppIterType, typename T = typename ValueTypeHelper<CppIterType>::value_type>
+        struct IsContiguousCppIterator : std::bool_constant<
+            std::is_pointer_v<CppIterType> ||
+            std::is_same_v<CppIterType, typename std::vector<T>::iterator> ||
+            std::is_same_v<CppIterType, typename std::vector<T>::const_iterator> ||
+            std::is_same_v<CppIterType, std::string::iterator> ||
+            std::is_same_v<CppIterType, std::string::const_iterator> ||
+            std::is_same_v<CppIterType, std::wstring::iterator> ||
+            std::is_same_v<CppIterType, std::wstring::const_iterator>>
+        {
+        };
 
-            return initialValue;
-        }
+        // std::vector<bool> is not contiguous
+        template <typename CppIterType>
+        struct IsContiguousCppIterator<CppIterType, bool> : std::bool_constant<std::is_pointer_v<CppIterType>>
+        {
+        };
 
-        // Consumes the iterator, and returns the number of elements in it.
-        template <typename T = size_t>
-        T count()
+        // Checks if a rusty iterator yields elements directly from contiguous memory,
+        // so that the remaining elements can be accessed as a slice.
+        template <typename IterType>
+        struct IsContiguousIter : std::false_type
         {
-            T count = T(0);
+        };
 
-            while (next())
-            {
-                ++count;
-            }
+        template <typename CppIterType>
+        struct IsContiguousIter<CppIteratorWrapper<CppIterType>> : IsContiguousCppIterator<CppIterType>
+        {
+        };
 
-            return count;
-        }
+        // Checks if a rusty iterator is fused, which means that after `next` returns null for the first time,
+        // it will always return null.
+        // Some iterators are not fused, e.g. generators which can return an empty value, then a non-empty value again.
+        template <typename IterType>
+        struct IsFusedIter : std::false_type
+        {
+        };
 
-        // Consumes the iterator, and returns its last element.
-        // If the iterator is empty, then an empty value is returned.
-        std::optional<OutType> last()
+        template <typename CppIterType>
+        struct IsFusedIter<CppIteratorWrapper<CppIterType>> : std::true_type
         {
-            const OutType* first = next();
-            if (!first)
-            {
-                // no elements, return an empty value
-                return { };
-            }
+        };
 
-            OutType last = *first;
-            while (const OutType* value = next())
-            {
-                last = *value;
-            }
+        template <typename GeneratorFunction>
+        struct IsFusedIter<FiniteGeneratorIter<GeneratorFunction>> : std::true_type
+        {
+        };
 
-            return last;
-        }
+        template <typename GeneratorFunction>
+        struct IsFusedIter<DoubleEndedFiniteGeneratorIter<GeneratorFunction>> : std::true_type
+        {
+        };
 
-        // Returns the element at the given index, by advancing the iterator idx + 1 times.
-        // If the iterator doesn't have enough elements, then an empty value is returned.
         template <typename T>
-        std::optional<OutType> nth(const T& idx)
+        struct IsFusedIter<EmptyIter<T>> : std::true_type
         {
-            T currentIdx = T(0);
-            while (const OutType* value = next())
-            {
-                if (currentIdx++ == idx)
-                {
-                    return *value;
-                }
-            }
+        };
 
-            return { };
-        }
+        template <typename IterType, typename Predicate>
+        struct IsFusedIter<TakeWhileIter<IterType, Predicate>> : std::true_type
+        {
+        };
 
-        // Calls the provided predicate on all elements of the iterator, and checks if all returned values are true.
-        // The process will stop at the first false value, so this function might not fully consume the iterator.
-        // For empty iterators, this function returns true.
-        template <typename Predicate>
-        bool all(const Predicate& predicate)
+        template <typename IterType, typename MapWhileFunction>
+        struct IsFusedIter<MapWhileIter<IterType, MapWhileFunction>> : std::true_type
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+        };
 
-            while (const OutType* value = next())
-            {
-                if (!predicate(*value))
-                {
-                    return false;
-                }
-            }
+        template <typename IterType>
+        struct IsFusedIter<FuseIter<IterType>> : std::true_type
+        {
+        };
 
-            return true;
-        }
+        // iterators which don't have their own state are fused if their underlying iterator is fused
 
-        // Calls the provided predicate on all elements of the iterator, and checks if any of the returned values is true.
-        // The process will stop at the first true value, so this function might not fully consume the iterator.
-        // For empty iterators, this function returns false.
-        template <typename Predicate>
-        bool any(const Predicate& predicate)
+        template <typename IterType, typename MapFunction>
+        struct IsFusedIter<MapIter<IterType, MapFunction>> : IsFusedIter<IterType>
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+        };
 
-            while (const OutType* value = next())
-            {
-                if (predicate(*value))
-                {
-                    return true;
-                }
-            }
+        template <typename IterType, typename FilterFunction>
+        struct IsFusedIter<FilterIter<IterType, FilterFunction>> : IsFusedIter<IterType>
+        {
+        };
 
-            return false;
-        }
+        template <typename IterType, typename FilterMapFunction>
+        struct IsFusedIter<FilterMapIter<IterType, FilterMapFunction>> : IsFusedIter<IterType>
+        {
+        };
 
-        // Advances the iterator until a value that satisfies the predicate is found.
-        // The process will stop at the first such value, so this function might not fully consume the iterator.
-        // If no element was found, then an empty value is returned.
-        template <typename Predicate>
-        std::optional<OutType> find(const Predicate& predicate)
+        template <typename IterType, typename InspectCallback>
+        struct IsFusedIter<InspectIter<IterType, InspectCallback>> : IsFusedIter<IterType>
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+        };
 
-            while (const OutType* value = next())
-            {
-                if (predicate(*value))
-                {
-                    return *value;
-                }
-            }
+        template <typename IterType>
+        struct IsFusedIter<ReverseIter<IterType>> : IsFusedIter<IterType>
+        {
+        };
 
-            return { };
-        }
+        // Checks if a rusty iterator is created from random access C++ iterators,
+        // so that its length is known, and it can be advanced by any number of elements in constant time.
+        template <typename IterType>
+        struct IsRandomAccessIter : std::false_type
+        {
+        };
 
-        // Advances the iterator until a value that satisfies the predicate is found, and returns its index.
-        // The process will stop at the first such value, so this function might not fully consume the iterator.
-        // If no element was found, then an empty value is returned.
-        template <typename Predicate, typename Position = size_t>
-        std::optional<Position> position(const Predicate& predicate)
+        template <typename CppIterType>
+        struct IsRandomAccessIter<CppIteratorWrapper<CppIterType>> : std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<CppIterType>::iterator_category>
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+        };
 
-            Position pos = Position(0);
-            while (const OutType* value = next())
+        // Returns the number of remaining elements in the iterator, if it can be determined without advancing the iterator.
+        template <typename IterType>
+        std::optional<size_t> known_len(const IterType& iter)
+        {
+            if constexpr (IsRandomAccessIter<IterType>::value)
             {
-                if (predicate(*value))
-                {
-                    return pos;
-                }
-
-                ++pos;
+                return iter.len();
+            }
+            else
+            {
+                return { };
             }
-
-            return { };
-        }
-
-        // Returns the minimum value in the iterator, comparing elements with the < operator.
-        // If there are multiple minimum values, then the first one is returned.
-        // If the iterator is empty, then an empty value is returned.
-        std::optional<OutType> min()
-        {
-            return min_by(detail::compare<OutType>);
         }
 
-        // Returns the minimum value in the iterator, comparing elements with the provided comparer function.
-        // If there are multiple minimum values, then the first one is returned.
-        // If the iterator is empty, then an empty value is returned.
-        template <typename Comparer>
-        std::optional<OutType> min_by(const Comparer& comparer)
+        // Advances a random access iterator past the leading elements for which `isBefore` returns true
+        // (the elements must be partitioned by it, e.g. all elements less than a value in a sorted iterator).
+        // First the number of skipped elements is bounded by checking the elements at exponentially growing distances,
+        // then it's found with a binary search, so skipping d elements takes O(log(d)) comparisons (galloping search).
+        // Returns the number of skipped elements.
+        template <typename IterType, typename IsBeforeFunction>
+        size_t gallop(IterType& iter, const IsBeforeFunction& isBefore)
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
-
-            const OutType* first = next();
-            if (!first)
+            size_t len = iter.len();
+            size_t bound = 1;
+            while (bound <= len && isBefore(*iter.get(bound - 1)))
             {
-                return { };
+                bound *= 2;
             }
 
-            OutType minValue = *first;
-            while (const OutType* value = next())
+            // the element at bound / 2 - 1 is before, and the one at bound - 1 is not (or it doesn't exist)
+            size_t low = bound / 2;
+            size_t high = bound - 1 < len ? bound - 1 : len;
+            while (low < high)
             {
-                const OutType& minValueConst = minValue;
-                if (comparer(*value, minValueConst) < 0)
+                size_t mid = low + (high - low) / 2;
+                if (isBefore(*iter.get(mid)))
                 {
-                    minValue = *value;
+                    low = mid + 1;
+                }
+                else
+                {
+                    high = mid;
                 }
             }
 
-            return minValue;
+            return iter.advance_by(low);
         }
 
-        // Returns the maximum value in the iterator, comparing elements with the > operator.
-        // If there are multiple maximum values, then the first one is returned.
-        // If the iterator is empty, then an empty value is returned.
-        std::optional<OutType> max()
+        // Checks if the pointers returned by a rusty iterator stay valid after the iterator is advanced
+        // (as long as the underlying collection exists), which is true if the values are not stored in the iterator itself.
+        // Iterators for which this is true can keep pointers to earlier values, instead of copying them.
+        template <typename IterType>
+        struct HasStablePointers : std::false_type
         {
-            return max_by(detail::compare<OutType>);
-        }
+        };
 
-        // Returns the maximum value in the iterator, comparing elements with the provided comparer function.
-        // If there are multiple maximum values, then the first one is returned.
-        // If the iterator is empty, then an empty value is returned.
-        template <typename Comparer>
-        std::optional<OutType> max_by(const Comparer& comparer)
+        // forward iterators (and pointers) must return references to values that are not owned by the iterator
+        template <typename CppIterType>
+        struct HasStablePointers<CppIteratorWrapper<CppIterType>> : std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<CppIterType>::iterator_category>
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+        };
 
-            const OutType* first = next();
-            if (!first)
+        template <typename IterType, typename FilterFunction>
+        struct HasStablePointers<FilterIter<IterType, FilterFunction>> : HasStablePointers<IterType>
+        {
+        };
+
+        template <typename IterType, typename Predicate>
+        struct HasStablePointers<SkipWhileIter<IterType, Predicate>> : HasStablePointers<IterType>
+        {
+        };
+
+        template <typename IterType, typename Predicate>
+        struct HasStablePointers<TakeWhileIter<IterType, Predicate>> : HasStablePointers<IterType>
+        {
+        };
+
+        template <typename IterType, typename InspectCallback>
+        struct HasStablePointers<InspectIter<IterType, InspectCallback>> : HasStablePointers<IterType>
+        {
+        };
+
+        template <typename IterType>
+        struct HasStablePointers<ReverseIter<IterType>> : HasStablePointers<IterType>
+        {
+        };
+
+        template <typename IterType, typename KeyFunction, typename EqualityFunction>
+        struct HasStablePointers<DedupIter<IterType, KeyFunction, EqualityFunction>> : HasStablePointers<IterType>
+        {
+        };
+
+        // Helper class which stores a value yielded by an iterator.
+        // If the iterator has stable pointers, then only the pointer is stored, otherwise the value is copied.
+        template <typename T, bool StorePointer>
+        struct StoredValue
+        {
+            StoredValue() : _value()
             {
-                return { };
             }
 
-            OutType maxValue = *first;
-            while (const OutType* value = next())
+            void set(const T* value)
             {
-                const OutType& maxValueConst = maxValue;
-                if (comparer(*value, maxValueConst) > 0)
+                _value.emplace(*value);
+            }
+
+            // Same as `set`, but the stored value is reset if the given pointer is null.
+            void assign(const T* value)
+            {
+                if (value)
                 {
-                    maxValue = *value;
+                    _value.emplace(*value);
+                }
+                else
+                {
+                    _value.reset();
                 }
             }
 
-            return maxValue;
-        }
-
-        // Returns the sum of all elements in the iterator, by adding all elements together.
-        // If the iterator is empty, then 0 is returned.
-        template <typename T = OutType>
-        T sum()
-        {
-            T sum = T(0);
+            const T* get() const
+            {
+                return _value ? &*_value : nullptr;
+            }
 
-            while (const OutType* value = next())
+            void reset()
             {
-                sum += *value;
+                _value.reset();
             }
 
-            return sum;
-        }
+        private:
+            std::optional<T> _value;
+        };
 
-        // Returns the product of all elements in the iterator, by multiplying all elements together.
-        // If the iterator is empty, then 1 is returned.
-        template <typename T = OutType>
-        T product()
+        template <typename T>
+        struct StoredValue<T, true>
         {
-            T product = T(1);
+            StoredValue() : _value(nullptr)
+            {
+            }
 
-            while (const OutType* value = next())
+            void set(const T* value)
             {
-                product *= *value;
+                _value = value;
             }
 
-            return product;
-        }
+            void assign(const T* value)
+            {
+                _value = value;
+            }
 
-        // Returns true if the iterator is sorted ascending, so that no element is less than the previous one.
-        // The process will stop when a non-sorted pair is encountered, so this function might not fully consume the iterator.
-        // For iterators with less than 2 elements, this function always returns true.
-        bool is_sorted_ascending()
-        {
-            return is_sorted_by(detail::compare<OutType>);
-        }
+            const T* get() const
+            {
+                return _value;
+            }
 
-        // Returns true if the iterator is sorted descending, so that no element is greater than the previous one.
-        // The process will stop when a non-sorted pair is encountered, so this function might not fully consume the iterator.
-        // For iterators with less than 2 elements, this function always returns true.
-        bool is_sorted_descending()
-        {
-            return is_sorted_by(detail::compare_reverse<OutType>);
-        }
+            void reset()
+            {
+                _value = nullptr;
+            }
 
-        // Returns true if the iterator is sorted by the given comparer.
-        // The comparer function must return:
-        // - a negative value if the first compared value is less than the second,
-        // - a positive value if the first compared value is greater than the second,
-        // - zero if they are equal
-        // The process will stop when a non-sorted pair is encountered, so this function might not fully consume the iterator.
-        // For iterators with less than 2 elements, this function always returns true.
-        template <typename Comparer>
-        bool is_sorted_by(const Comparer& comparer)
+        private:
+            const T* _value;
+        };
+
+        // Helper class which stores the key of an element, so that the key function is only called once per element.
+        // For Identity, nothing is stored, the key is the element itself.
+        template <typename T, typename KeyFunction>
+        struct StoredKey
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+            using KeyType = std::decay_t<typename ReturnTypeHelperConstRefOrValue<KeyFunction, T>::type>;
 
-            const OutType* first = next();
-            if (!first)
+            StoredKey() : _key()
             {
-                // no elements, return true
-                return true;
             }
 
-            OutType prev = *first;
-            while (const OutType* value = next())
+            void set(const KeyFunction& keyFunction, const T& value)
             {
-                const OutType& prevConst = prev;
-                if (comparer(prevConst, *value) > 0)
-                {
-                    // not sorted, return false immediately
-                    return false;
-                }
-
-                prev = *value;
+                _key.emplace(keyFunction(value));
             }
 
-            return true;
-        }
+            const KeyType& get(const T&) const
+            {
+                return *_key;
+            }
 
-        //
-        // Comparison functions
-        //
+        private:
+            std::optional<KeyType> _key;
+        };
 
-        // Lexicographically compares the elements of this iterator with another iterator's elements, using the provided comparison function.
-        // The comparison function must be a partial comparer, which means that it can return an empty value if the elements cannot be compared.
-        // If the elements can be compared, then the usual <0, 0, and >0 must be returned.
-        // Returns -1 if this iterator is less than the other iterator, 0 if they are equal, and 1 if this iterator is greater than the other iterator.
-        // Returns an empty value if there was at least one pair of elements that could not be compared.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType, typename PartialComparisonFunction>
-        std::optional<char> partial_cmp_by(OtherIterType&& other, const PartialComparisonFunction& partialComparisonFunction)
+        template <typename T>
+        struct StoredKey<T, Identity>
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<PartialComparisonFunction, const OutType&, const OutType&>::check();
+            void set(const Identity&, const T&)
+            {
+            }
 
-            while (true)
+            const T& get(const T& value) const
             {
-                const OutType* thisValue = next();
-                const OutType* otherValue = other.next();
+                return value;
+            }
+        };
+    }
 
-                if (!thisValue)
-                {
-                    if (otherValue)
-                    {
-                        // current iterator has finished before the other, so this < other
-                        return -1;
-                    }
-                    else
-                    {
-                        // both iterators have finished at the same time, so this == other
-                        return 0;
-                    }
-                }
 
-                if (!otherValue)
-                {
-                    // other iterator has finished before the current, so this > other
-                    return 1;
-                }
+    //
+    // Slice
+    //
 
-                // none of the iterators have finished yet, compare the values
-                std::optional<char> compared = partialComparisonFunction(*thisValue, *otherValue);
-                if (!compared || *compared != 0)
-                {
-                    // values are different or cannot be compared, return the result
-                    return compared;
-                }
-                else
-                {
-                    // values are equal, check the next ones
-                }
-            }
+    // A non-owning view of a contiguous sequence of elements, similar to a slice in Rust.
+    // Slices are yielded by iterators such as `chunks`, and they point either directly into the original
+    // collection (if the source iterator is contiguous), or into a buffer owned by the iterator that created them.
+    // In the latter case, the slice only stays valid until the iterator is advanced again, just like the values returned by `next`.
+    template <typename T>
+    struct Slice
+    {
+        using value_type = T;
+        using iterator = const T*;
+        using const_iterator = const T*;
+
+        Slice() : _data(nullptr), _size(0)
+        {
         }
 
-        // Lexicographically compares the elements of this iterator with another iterator's elements, using the provided comparison function.
-        // Returns -1 if this iterator is less than the other iterator, 0 if they are equal, and 1 if this iterator is greater than the other iterator.
-        // Returns an empty value if there was at least one pair of elements that could not be compared.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType>
-        std::optional<char> partial_cmp(OtherIterType&& other)
+        Slice(const T* data, size_t size) : _data(data), _size(size)
         {
-            return partial_cmp_by(other, detail::compare_partial<OutType>);
         }
 
-        // Lexicographically compares the elements of this iterator with another iterator's elements, using the provided comparison function.
-        // Returns -1 if this iterator is less than the other iterator, 0 if they are equal, and 1 if this iterator is greater than the other iterator.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType, typename ComparisonFunction>
-        char cmp_by(OtherIterType&& other, const ComparisonFunction& comparisonFunction)
+        const T* data() const
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<ComparisonFunction, const OutType&, const OutType&>::check();
+            return _data;
+        }
 
-            auto partialComparisonFunction = [&](const OutType& a, const OutType& b) -> std::optional<OutType>
-            {
-                return comparisonFunction(a, b);
-            };
+        size_t size() const
+        {
+            return _size;
+        }
 
-            // we always return a non-empty value in our comparer, so we can just get the value
-            return *partial_cmp_by(other, partialComparisonFunction);
+        bool empty() const
+        {
+            return _size == 0;
         }
 
-        // Lexicographically compares the elements of this iterator with another iterator's elements.
-        // Returns -1 if this iterator is less than the other iterator, 0 if they are equal, and 1 if this iterator is greater than the other iterator.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType>
-        char cmp(OtherIterType&& other)
+        const T& operator[](size_t idx) const
         {
-            return cmp_by(other, detail::compare<OutType>);
+            return _data[idx];
         }
 
-        // Determines if the elements of this iterator are equal to the elements of another iterator, using the provided equality comparer function.
-        // Returns true only if both iterators have the same number of elements, and all elements are equal.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType, typename EqualityComparerFunction>
-        bool eq_by(OtherIterType&& other, const EqualityComparerFunction& equalityComparerFunction)
+        const T* begin() const
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<EqualityComparerFunction, const OutType&, const OutType&>::check();
+            return _data;
+        }
 
-            while (true)
-            {
-                const OutType* thisValue = next();
-                const OutType* otherValue = other.next();
+        const T* end() const
+        {
+            return _data + _size;
+        }
 
-                if (!thisValue)
-                {
-                    // this iterator has finished, the two iterators can only be equal if the other iterator has finished too
-                    return !otherValue;
-                }
+    private:
+        const T* _data;
+        size_t _size;
+    };
 
-                if (!otherValue)
-                {
-                    // other iterator has finished before the current, so they cannot be equal
-                    return false;
-                }
 
-                // none of the iterators have finished yet, check equality
-                if (!equalityComparerFunction(*thisValue, *otherValue))
-                {
-                    // values are different
-                    return false;
-                }
-                else
-                {
-                    // values are equal, check the next ones
-                }
-            }
-        }
+    //
+    // Traits
+    //
 
-        // Determines if the elements of this iterator are equal to the elements of another iterator.
-        // Returns true only if both iterators have the same number of elements, and all elements are equal.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType>
-        bool eq(OtherIterType&& other)
-        {
-            return eq_by(other, [](const OutType& a, const OutType& b) { return a == b; });
-        }
+    // True if the given rusty iterator type supports random access (e.g. iterators created from vectors, arrays or deques).
+    // Searching functions like `partition_point` and `binary_search` take O(log(n)) time on these iterators, and O(n) on others,
+    // so this can be used in a static_assert to make sure that the fast version is used.
+    template <typename IterType>
+    constexpr bool is_random_access_v = detail::IsRandomAccessIter<IterType>::value;
 
-        // Determines if the elements of this iterator are not equal to the elements of another iterator.
-        // Returns true if the iterators have a different number of elements, or if there is at least one pair of elements that are different.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType>
-        bool ne(OtherIterType&& other)
-        {
-            return !eq(other);
-        }
 
-        // Lexicographically compares the elements of this iterator with another iterator's elements.
-        // Returns true if this iterator is less than the other iterator, false otherwise.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType>
-        bool lt(OtherIterType&& other)
-        {
-            std::optional<char> cmp = partial_cmp(other);
-            return cmp && *cmp < 0;
-        }
+    //
+    // Quantile sketch
+    //
 
-        // Lexicographically compares the elements of this iterator with another iterator's elements.
-        // Returns true if this iterator is less than or equal to the other iterator, false otherwise.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType>
-        bool le(OtherIterType&& other)
+    // A sketch which estimates the quantiles of a stream of values with a fixed amount of memory, using the KLL algorithm.
+    // The values are stored in levels of compactors, where each value at level h represents 2^h values of the stream.
+    // When the sketch is full, the lowest full level is sorted, and every other value of it (starting at a random offset)
+    // is moved to the next level, while the rest are discarded.
+    // The rank of the returned quantiles is within about epsilon * count of the requested rank with high probability,
+    // and the sketch stores O(1 / epsilon) values, no matter how many values are inserted.
+    // Sketches can be merged, so the values can be processed in parallel, or in separate shards.
+    // The values are compared with the < operator.
+    template <typename T>
+    struct QuantileSketch
+    {
+        explicit QuantileSketch(double epsilon = 0.01) :
+            _k(epsilon > 0.0 && 2.0 / epsilon < 65536.0 ? static_cast<size_t>(2.0 / epsilon) : 65536), _count(0), _retained(0),
+            _levels(1), _capacities(), _totalCapacity(0), _min(), _max(), _random(0x9e3779b97f4a7c15ull)
         {
-            std::optional<char> cmp = partial_cmp(other);
-            return cmp && *cmp <= 0;
+            if (_k < MinK)
+            {
+                _k = MinK;
+            }
+
+            update_capacities();
         }
 
-        // Lexicographically compares the elements of this iterator with another iterator's elements.
-        // Returns true if this iterator is greater than the other iterator, false otherwise.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType>
-        bool gt(OtherIterType&& other)
+        // Adds a value to the sketch.
+        void insert(const T& value)
         {
-            std::optional<char> cmp = partial_cmp(other);
-            return cmp && *cmp > 0;
+            update_min_max(value, value);
+            ++_count;
+
+            _levels[0].push_back(value);
+            ++_retained;
+            compress();
         }
 
-        // Lexicographically compares the elements of this iterator with another iterator's elements.
-        // Returns true if this iterator is greater than or equal to the other iterator, false otherwise.
-        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
-        template <typename OtherIterType>
-        bool ge(OtherIterType&& other)
+        // Merges the values of the other sketch into this sketch, as if all values of the other sketch were inserted into this one.
+        // If the sketches were created with different epsilon values, then the result has the larger error.
+        void merge(const QuantileSketch& other)
         {
-            std::optional<char> cmp = partial_cmp(other);
-            return cmp && *cmp >= 0;
-        }
+            if (&other == this)
+            {
+                // the levels of the other sketch would be modified while they are inserted
+                QuantileSketch copy(other);
+                merge(copy);
+                return;
+            }
 
-        //
-        // Iterator functions
-        //
+            if (other._count == 0)
+            {
+                return;
+            }
 
-        // Creates an iterator that steps multiple times with each iteration, by the given step amount.
-        // Using 1 as the step value will produce identical behavior to the original iterator.
-        // Using step values that are less than 1 are invalid, and will create an empty iterator.
-        template <typename T>
-        detail::StepByIter<ConcreteIterType, T> step_by(const T& stepSize)
-        {
-            return detail::StepByIter<ConcreteIterType, T>(*concrete_iter(), stepSize);
+            update_min_max(*other._min, *other._max);
+            _count += other._count;
+
+            if (other._k < _k)
+            {
+                _k = other._k;
+            }
+
+            if (_levels.size() < other._levels.size())
+            {
+                _levels.resize(other._levels.size());
+            }
+
+            update_capacities();
+
+            for (size_t level = 0; level < other._levels.size(); ++level)
+            {
+                _levels[level].insert(_levels[level].end(), other._levels[level].begin(), other._levels[level].end());
+            }
+
+            _retained += other._retained;
+            compress();
         }
 
-        // Appends an iterator to the end of the current iterator.
-        // This new iterator will yield elements from the first iterator until it finishes, then from the second iterator.
-        template <typename ChainedIterType>
-        detail::ChainIter<ConcreteIterType, ChainedIterType> chain(const ChainedIterType& chainedIter)
+        // Returns the number of values inserted into the sketch.
+        size_t count() const
         {
-            return detail::ChainIter<ConcreteIterType, ChainedIterType>(*concrete_iter(), chainedIter);
+            return _count;
         }
 
-        // Creates an iterator that iterates over two iterators in parallel.
-        // This new iterator will yield a pair of elements,
-        // the first element is from the first iterator, the second element is from the second.
-        // This iterator will stop yielding elements when any of the iterators are finished.
-        template <typename ZippedIterType>
-        detail::ZipIter<ConcreteIterType, ZippedIterType> zip(const ZippedIterType& zippedIter)
+        // Returns true if no values were inserted into the sketch.
+        bool empty() const
         {
-            return detail::ZipIter<ConcreteIterType, ZippedIterType>(*concrete_iter(), zippedIter);
+            return _count == 0;
         }
 
-        // Creates an iterator that inserts a separator value between each element.
-        // The separator will not be inserted before the first element, nor after the last element.
-        detail::IntersperseWithIter<ConcreteIterType, detail::Getter<OutType>> intersperse(const OutType& separator)
+        // Returns the number of values currently stored in the sketch.
+        size_t retained() const
         {
-            return detail::IntersperseWithIter<ConcreteIterType, detail::Getter<OutType>>(*concrete_iter(), detail::Getter<OutType>(separator));
+            return _retained;
         }
 
-        // Creates an iterator that inserts a separator value between each element.
-        // The current separator value is obtained by calling the provided separatorGetter function.
-        // The separator will not be inserted before the first element, nor after the last element.
-        template <typename SeparatorGetter>
-        detail::IntersperseWithIter<ConcreteIterType, SeparatorGetter> intersperse_with(const SeparatorGetter& separatorGetter)
+        // Returns the estimated value at the given quantile (a number between 0 and 1).
+        // Quantile 0 returns the exact minimum, and quantile 1 returns the exact maximum.
+        // If the sketch is empty, then an empty optional is returned.
+        std::optional<T> quantile(double fraction) const
         {
-            return detail::IntersperseWithIter<ConcreteIterType, SeparatorGetter>(*concrete_iter(), separatorGetter);
+            std::vector<T> result = quantiles({ fraction });
+            if (result.empty())
+            {
+                return { };
+            }
+
+            return std::move(result[0]);
         }
 
-        // Transforms all values in the iterator, replacing each element with a new one.
-        // The provided map function takes the old value, and returns the new value.
-        // The old and the new values can have different types.
-        template <typename MapFunction>
-        detail::MapIter<ConcreteIterType, MapFunction> map(const MapFunction& mapFunction)
+        // Returns the estimated values at the given quantiles (numbers between 0 and 1), in the same order as the requested quantiles.
+        // Same as calling `quantile` for each of them, but the stored values are only sorted once.
+        // Quantiles outside of [0, 1] are clamped, and NaN is treated as 0.
+        // If the sketch is empty, then an empty vector is returned.
+        std::vector<T> quantiles(const std::vector<double>& fractions) const
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<MapFunction, const OutType&>::check();
+            std::vector<T> result;
+            if (_count == 0)
+            {
+                return result;
+            }
 
-            return detail::MapIter<ConcreteIterType, MapFunction>(*concrete_iter(), mapFunction);
+            // (value, weight) pairs, sorted by value
+            std::vector<std::pair<const T*, std::uint64_t>> weighted;
+            weighted.reserve(_retained);
+            for (size_t level = 0; level < _levels.size(); ++level)
+            {
+                for (const T& value : _levels[level])
+                {
+                    weighted.emplace_back(&value, std::uint64_t(1) << level);
+                }
+            }
+
+            std::sort(weighted.begin(), weighted.end(), [](const auto& a, const auto& b) { return *a.first < *b.first; });
+
+            result.reserve(fractions.size());
+            for (double fraction : fractions)
+            {
+                double quantile = detail::clamp_quantile(fraction);
+                if (quantile == 0.0)
+                {
+                    result.push_back(*_min);
+                    continue;
+                }
+
+                if (quantile == 1.0)
+                {
+                    result.push_back(*_max);
+                    continue;
+                }
+
+                // same as for `Iterator::quantiles`, the value at rank floor(q * (count - 1)) is returned
+                std::uint64_t rank = static_cast<std::uint64_t>(quantile * static_cast<double>(_count - 1));
+                std::uint64_t cumulativeWeight = 0;
+                const T* found = weighted.back().first;
+                for (const auto& [value, weight] : weighted)
+                {
+                    cumulativeWeight += weight;
+                    if (cumulativeWeight > rank)
+                    {
+                        found = value;
+                        break;
+                    }
+                }
+
+                result.push_back(*found);
+            }
+
+            return result;
         }
 
-        // Creates an iterator that only yields elements that satisfy the filter function.
-        // Elements that the filter function returns false for are skipped, the rest are kept.
-        template <typename FilterFunction>
-        detail::FilterIter<ConcreteIterType, FilterFunction> filter(const FilterFunction& filterFunction)
+    private:
+        static constexpr size_t MinK = 8;
+
+        void update_min_max(const T& minValue, const T& maxValue)
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<FilterFunction, const OutType&>::check();
+            if (!_min || minValue < *_min)
+            {
+                _min = minValue;
+            }
 
-            return detail::FilterIter<ConcreteIterType, FilterFunction>(*concrete_iter(), filterFunction);
+            if (!_max || *_max < maxValue)
+            {
+                _max = maxValue;
+            }
         }
 
-        // Creates an iterator that filters and maps at the same time.
-        // The provided filterMap function takes the old value, and must return a non-empty std::optional value
-        // if the current element should be kept (and transformed),
-        // and must return an empty value if the element should be skipped.
-        template <typename FilterMapFunction>
-        detail::FilterMapIter<ConcreteIterType, FilterMapFunction> filter_map(const FilterMapFunction& filterMapFunction)
+        // The capacity of the levels decreases geometrically (by a factor of 2/3) from the top level downwards,
+        // but each level can store at least 2 values.
+        // The capacities only depend on k and the number of levels, so they are only recalculated when one of those changes.
+        void update_capacities()
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<FilterMapFunction, const OutType&>::check();
+            _capacities.resize(_levels.size());
+            _totalCapacity = 0;
 
-            return detail::FilterMapIter<ConcreteIterType, FilterMapFunction>(*concrete_iter(), filterMapFunction);
+            double capacity = static_cast<double>(_k);
+            for (size_t level = _levels.size(); level-- > 0;)
+            {
+                size_t result = static_cast<size_t>(capacity);
+                _capacities[level] = result < 2 ? 2 : result;
+                _totalCapacity += _capacities[level];
+                capacity *= 2.0 / 3.0;
+            }
         }
 
-        // Creates an iterator which has an extra `peek` function, which allows you
-        // to retrieve the next value in the iterator without advancing the current iterator.
-        // Note that the underlying iterator is still advanced to get the next value when `peek` is called.
-        detail::PeekableIter<ConcreteIterType> peekable()
+        void compress()
         {
-            return detail::PeekableIter<ConcreteIterType>(*concrete_iter());
+            while (_retained > _totalCapacity)
+            {
+                for (size_t level = 0; level < _levels.size(); ++level)
+                {
+                    if (_levels[level].size() >= _capacities[level])
+                    {
+                        compact(level);
+                        break;
+                    }
+                }
+            }
         }
 
-        // Creates an iterator that skips elements while the given predicate returns true.
-        // When the predicate returns false for the first time, then no more items will be skipped.
-        template <typename Predicate>
-        detail::SkipWhileIter<ConcreteIterType, Predicate> skip_while(const Predicate& pred)
+        // Sorts the values of the level, then moves every other value to the next level, and discards the others.
+        // If the number of values is odd, then the smallest value stays in the current level.
+        void compact(size_t level)
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+            if (level + 1 == _levels.size())
+            {
+                _levels.emplace_back();
+                update_capacities();
+            }
 
-            return detail::SkipWhileIter<ConcreteIterType, Predicate>(*concrete_iter(), pred);
-        }
+            std::vector<T>& current = _levels[level];
+            std::vector<T>& next = _levels[level + 1];
+            std::sort(current.begin(), current.end(), [](const T& a, const T& b) { return a < b; });
 
-        // Creates an iterator that yields elements only while the given predicate returns true.
-        // When the predicate returns false for the first time, then the rest of the elements are skipped.
-        template <typename Predicate>
-        detail::TakeWhileIter<ConcreteIterType, Predicate> take_while(const Predicate& pred)
-        {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+            size_t kept = current.size() % 2;
+            size_t originalSize = current.size();
+            for (size_t i = kept + random_bit(); i < originalSize; i += 2)
+            {
+                next.push_back(std::move(current[i]));
+            }
 
-            return detail::TakeWhileIter<ConcreteIterType, Predicate>(*concrete_iter(), pred);
+            current.erase(current.begin() + kept, current.end());
+            _retained -= (originalSize - kept) / 2;
         }
 
-        // Creates an iterator which skips the given number of elements,
-        // by advancing the underlying iterator that many times.
-        // If the underlying iterator is too short, then this function creates an empty iterator.
-        template <typename T = size_t>
-        detail::SkipWhileIter<ConcreteIterType, detail::Counter<T>> skip(const T& count)
+        size_t random_bit()
         {
-            return detail::SkipWhileIter<ConcreteIterType, detail::Counter<T>>(*concrete_iter(), detail::Counter<T>(count));
+            // xorshift64
+            _random ^= _random << 13;
+            _random ^= _random >> 7;
+            _random ^= _random << 17;
+            return static_cast<size_t>(_random & 1);
         }
 
-        // Creates an iterator which yields the given number of elements at most.
-        // If the underlying iterator is too short, then less elements will be yielded.
-        template <typename T = size_t>
-        detail::TakeWhileIter<ConcreteIterType, detail::Counter<T>> take(const T& count)
+        size_t _k;
+        size_t _count;
+        size_t _retained;
+        std::vector<std::vector<T>> _levels;
+        std::vector<size_t> _capacities;
+        size_t _totalCapacity;
+        std::optional<T> _min;
+        std::optional<T> _max;
+        std::uint64_t _random;
+    };
+
+
+    //
+    // Distinct count sketch
+    //
+
+    // A sketch which estimates the number of distinct values in a stream of values with a fixed amount of memory, using the HyperLogLog algorithm.
+    // Each value is hashed, the first `precision` bits of the hash select one of 2^precision registers,
+    // and the register stores the maximum number of leading zeros (plus one) seen in the rest of the hash.
+    // The relative error of the estimate is about 1.04 / sqrt(2^precision), so the default precision of 14 gives about 0.8% error with 16 KB of memory.
+    // Sketches can be merged, so the values can be processed in parallel, or in separate shards.
+    // The values are hashed with the provided hash function (std::hash by default), which is mixed further, so it doesn't have to be a high quality hash.
+    template <typename T, typename Hash = std::hash<T>>
+    struct DistinctCountSketch
+    {
+        static constexpr unsigned MinPrecision = 4;
+        static constexpr unsigned MaxPrecision = 18;
+
+        // The precision is clamped to [MinPrecision, MaxPrecision].
+        explicit DistinctCountSketch(unsigned precision = 14, const Hash& hash = Hash()) :
+            _precision(precision < MinPrecision ? MinPrecision : (precision > MaxPrecision ? MaxPrecision : precision)),
+            _registers(size_t(1) << _precision, 0), _hash(hash)
         {
-            return detail::TakeWhileIter<ConcreteIterType, detail::Counter<T>>(*concrete_iter(), detail::Counter<T>(count));
         }
 
-        // Creates an iterator which yields the current element as well as its index in the current iterator.
-        // The new iterator returns pairs, where the first element is the index, and the second element is the value.
-        template <typename T = size_t>
-        detail::ZipIter<detail::GeneratorIter<detail::InfiniteRangeGenerator<T>>, ConcreteIterType> enumerate()
+        // Adds a value to the sketch.
+        void insert(const T& value)
         {
-            using Generator = detail::InfiniteRangeGenerator<T>;
-            using GeneratorIterType = detail::GeneratorIter<Generator>;
-            return detail::ZipIter<GeneratorIterType, ConcreteIterType>(GeneratorIterType(Generator(0, 1)), *concrete_iter());
+            std::uint64_t hash = detail::mix_hash64(static_cast<std::uint64_t>(_hash(value)));
+            size_t index = static_cast<size_t>(hash >> (64 - _precision));
+            std::uint64_t remaining = hash << _precision;
+
+            // the rank can be at most 64 - precision + 1, if all remaining bits are zero
+            unsigned zeros = detail::leading_zeros64(remaining);
+            std::uint8_t rank = static_cast<std::uint8_t>((zeros > 64 - _precision ? 64 - _precision : zeros) + 1);
+            if (rank > _registers[index])
+            {
+                _registers[index] = rank;
+            }
         }
 
-        // Creates an iterator from an iterator of iterators, which removes one level of nesting.
-        // Note that this function can only be called on nested iterators.
-        detail::FlattenIter<ConcreteIterType> flatten()
+        // Merges the values of the other sketch into this sketch, as if all values of the other sketch were inserted into this one.
+        // If the sketches have different precisions, then the result has the lower one of them.
+        void merge(const DistinctCountSketch& other)
         {
-            return detail::FlattenIter<ConcreteIterType>(*concrete_iter());
+            if (other._precision < _precision)
+            {
+                std::vector<std::uint8_t> registers(size_t(1) << other._precision, 0);
+                fold(_registers, _precision, registers, other._precision);
+                _registers = std::move(registers);
+                _precision = other._precision;
+            }
+
+            fold(other._registers, other._precision, _registers, _precision);
         }
 
-        // Creates an iterator that will call the provided inspect function on each value before yielding them.
-        // The inspect function cannot change those values, only read (inspect) them.
-        // This function can be useful for debugging.
-        template <typename InspectFunction>
-        detail::InspectIter<ConcreteIterType, InspectFunction> inspect(const InspectFunction& inspectFunction)
+        // Returns the estimated number of distinct values inserted into the sketch.
+        size_t estimate() const
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<InspectFunction, const OutType&>::check();
+            double registerCount = static_cast<double>(_registers.size());
+            double sum = 0.0;
+            size_t zeroRegisters = 0;
+            for (std::uint8_t rank : _registers)
+            {
+                sum += std::ldexp(1.0, -static_cast<int>(rank));
+                zeroRegisters += rank == 0 ? 1 : 0;
+            }
 
-            return detail::InspectIter<ConcreteIterType, InspectFunction>(*concrete_iter(), inspectFunction);
+            double alpha = registerCount == 16.0 ? 0.673 : (registerCount == 32.0 ? 0.697 : (registerCount == 64.0 ? 0.709 : 0.7213 / (1.0 + 1.079 / registerCount)));
+            double estimate = alpha * registerCount * registerCount / sum;
+
+            // use linear counting for small cardinalities, where the raw estimate is biased
+            if (estimate <= 2.5 * registerCount && zeroRegisters != 0)
+            {
+                estimate = registerCount * std::log(registerCount / static_cast<double>(zeroRegisters));
+            }
+
+            return static_cast<size_t>(estimate + 0.5);
         }
 
-        // Creates an iterator that repeats the current iterator endlessly.
-        // When that iterator is finshed, it will start again at the beginning, instead of finishing.
-        // If the current iterator is empty, then the cycled iterator will also be empty.
-        detail::CycleIter<ConcreteIterType> cycle()
+        // Returns true if no values were inserted into the sketch.
+        bool empty() const
         {
-            return detail::CycleIter<ConcreteIterType>(*concrete_iter());
+            return std::all_of(_registers.begin(), _registers.end(), [](std::uint8_t rank) { return rank == 0; });
         }
 
-        //
-        // C++ iterator functionality
-        //
+        // Returns the precision of the sketch (the number of hash bits used to select a register).
+        unsigned precision() const
+        {
+            return _precision;
+        }
 
-        struct CppIterator
+    private:
+        // Merges registers into registers of the same or lower precision.
+        // With a lower precision, the last bits of the source index become the first bits of the remaining hash bits,
+        // so the rank only depends on the source register if those bits are all zero.
+        static void fold(const std::vector<std::uint8_t>& source, unsigned sourcePrecision, std::vector<std::uint8_t>& target, unsigned targetPrecision)
+        {
+            unsigned shift = sourcePrecision - targetPrecision;
+            for (size_t index = 0; index < source.size(); ++index)
+            {
+                if (source[index] == 0)
+                {
+                    continue;
+                }
+
+                std::uint64_t movedBits = static_cast<std::uint64_t>(index) & ((std::uint64_t(1) << shift) - 1);
+                std::uint8_t rank = movedBits == 0
+                    ? static_cast<std::uint8_t>(source[index] + shift)
+                    : static_cast<std::uint8_t>(detail::leading_zeros64(movedBits << (64 - shift)) + 1);
+
+                std::uint8_t& targetRank = target[index >> shift];
+                if (rank > targetRank)
+                {
+                    targetRank = rank;
+                }
+            }
+        }
+
+        unsigned _precision;
+        std::vector<std::uint8_t> _registers;
+        Hash _hash;
+    };
+
+
+    //
+    // Statistics
+    //
+
+    // Forward declaration
+    template <typename ConcreteIterType, typename OutType>
+    struct Iterator;
+
+    // Count, mean, variance, minimum and maximum of numeric values, computed in a single pass.
+    // The mean and variance are updated with Welford's algorithm, which is numerically stable,
+    // unlike computing the variance from the sum of squares. The values are converted to double for the mean and variance.
+    // Statistics can be merged (using Chan's formula), so the values can be processed in parallel, or in separate shards.
+    template <typename T>
+    struct Statistics
+    {
+        template <typename ConcreteIterType, typename OutType>
+        friend struct Iterator;
+
+        Statistics() : _count(0), _mean(0.0), _m2(0.0), _min(), _max()
+        {
+        }
+
+        // Adds a value to the statistics.
+        void insert(const T& value)
+        {
+            update_min_max(value, value);
+
+            ++_count;
+            double x = static_cast<double>(value);
+            double delta = x - _mean;
+            _mean += delta / static_cast<double>(_count);
+            _m2 += delta * (x - _mean);
+        }
+
+        // Merges the other statistics into these statistics, as if all values of the other statistics were inserted into these ones.
+        void merge(const Statistics& other)
+        {
+            if (other._count == 0)
+            {
+                return;
+            }
+
+            merge_parts(other._count, other._mean, other._m2, *other._min, *other._max);
+        }
+
+        // Returns the number of values.
+        size_t count() const
+        {
+            return _count;
+        }
+
+        // Returns true if there are no values.
+        bool empty() const
+        {
+            return _count == 0;
+        }
+
+        // Returns the arithmetic mean of the values, or 0 if there are no values.
+        double mean() const
+        {
+            return _mean;
+        }
+
+        // Returns the population variance of the values (the mean of the squared deviations from the mean), or 0 if there are no values.
+        double variance() const
+        {
+            return _count == 0 ? 0.0 : _m2 / static_cast<double>(_count);
+        }
+
+        // Returns the sample variance of the values (with Bessel's correction, dividing by count - 1), or 0 if there are less than 2 values.
+        double sample_variance() const
+        {
+            return _count < 2 ? 0.0 : _m2 / static_cast<double>(_count - 1);
+        }
+
+        // Returns the population standard deviation of the values (the square root of `variance`).
+        double stddev() const
+        {
+            return std::sqrt(variance());
+        }
+
+        // Returns the sample standard deviation of the values (the square root of `sample_variance`).
+        double sample_stddev() const
+        {
+            return std::sqrt(sample_variance());
+        }
+
+        // Returns the minimum value, or an empty optional if there are no values.
+        const std::optional<T>& min() const
+        {
+            return _min;
+        }
+
+        // Returns the maximum value, or an empty optional if there are no values.
+        const std::optional<T>& max() const
+        {
+            return _max;
+        }
+
+    private:
+        static constexpr size_t BlockSize = 256;
+
+        void update_min_max(const T& minValue, const T& maxValue)
+        {
+            if (!_min || minValue < *_min)
+            {
+                _min = minValue;
+            }
+
+            if (!_max || *_max < maxValue)
+            {
+                _max = maxValue;
+            }
+        }
+
+        void merge_parts(size_t count, double mean, double m2, const T& minValue, const T& maxValue)
+        {
+            update_min_max(minValue, maxValue);
+
+            size_t totalCount = _count + count;
+            double delta = mean - _mean;
+            double weight = static_cast<double>(count) / static_cast<double>(totalCount);
+            _mean += delta * weight;
+            _m2 += m2 + delta * delta * static_cast<double>(_count) * weight;
+            _count = totalCount;
+        }
+
+        // Adds contiguous arithmetic values in blocks: for each block, the sum, then the squared deviations from the block mean
+        // are accumulated with simple loops that the compiler can vectorize, then the block is merged into the statistics.
+        // This is as stable as Welford's algorithm, because the deviations are computed from the exact mean of the block.
+        void insert_contiguous(const T* data, size_t size)
+        {
+            for (size_t blockStart = 0; blockStart < size; blockStart += BlockSize)
+            {
+                const T* block = data + blockStart;
+                size_t blockSize = size - blockStart < BlockSize ? size - blockStart : BlockSize;
+
+                double sum = 0.0;
+                for (size_t i = 0; i < blockSize; ++i)
+                {
+                    sum += static_cast<double>(block[i]);
+                }
+
+                double mean = sum / static_cast<double>(blockSize);
+                double m2 = 0.0;
+                for (size_t i = 0; i < blockSize; ++i)
+                {
+                    double deviation = static_cast<double>(block[i]) - mean;
+                    m2 += deviation * deviation;
+                }
+
+                T minValue;
+                T maxValue;
+                detail::minmax_contiguous(block, blockSize, minValue, maxValue);
+                merge_parts(blockSize, mean, m2, minValue, maxValue);
+            }
+        }
+
+        size_t _count;
+        double _mean;
+        double _m2;
+        std::optional<T> _min;
+        std::optional<T> _max;
+    };
+
+
+    //
+    // Heavy hitters sketch
+    //
+
+    // A sketch which finds the most frequent values in a stream of values with a fixed amount of memory, using the Space-Saving algorithm.
+    // At most `capacity` values are tracked with a counter. When a new value arrives and all counters are used,
+    // the value with the smallest counter is replaced with the new one, and the new counter continues from the old count.
+    // This way the counts are never underestimated, and every value which occurs more than count / capacity times is guaranteed to be tracked.
+    // Sketches can be merged, so the values can be processed in parallel, or in separate shards.
+    // The values are hashed with the provided hash function (std::hash by default), and compared with the == operator.
+    template <typename T, typename Hash = std::hash<T>>
+    struct HeavyHittersSketch
+    {
+        // A tracked value, with its estimated count. The count is an upper bound of the real count,
+        // and `count - error` is a lower bound of it.
+        struct Item
+        {
+            T value;
+            size_t count;
+            size_t error;
+        };
+
+        explicit HeavyHittersSketch(size_t capacity) : _capacity(capacity), _total(0), _heap(), _positions()
+        {
+            _heap.reserve(capacity);
+            _positions.reserve(capacity);
+        }
+
+        // Adds a value to the sketch, the given number of times.
+        void insert(const T& value, size_t count = 1)
+        {
+            _total += count;
+            if (_capacity == 0)
+            {
+                return;
+            }
+
+            if (size_t* position = _positions.find(value))
+            {
+                size_t index = *position;
+                _heap[index].count += count;
+                sift_down(index);
+            }
+            else if (_heap.size() < _capacity)
+            {
+                _heap.push_back(Item{ value, count, 0 });
+                _positions.insert(value, _heap.size() - 1);
+                sift_up(_heap.size() - 1);
+            }
+            else
+            {
+                // replace the value with the smallest count
+                size_t minCount = _heap[0].count;
+                _positions.erase(_heap[0].value);
+                _heap[0] = Item{ value, minCount + count, minCount };
+                _positions.insert(value, 0);
+                sift_down(0);
+            }
+        }
+
+        // Merges the other sketch into this sketch.
+        // The counts of values which are tracked by both sketches are added together. If a value is only tracked by one sketch,
+        // then the smallest count of the other sketch is added to it (if that sketch is full), because the value might have been evicted from there.
+        // Then the values with the largest counts are kept. The capacity of the result is the capacity of this sketch.
+        void merge(const HeavyHittersSketch& other)
+        {
+            size_t minCount = is_full() ? _heap[0].count : 0;
+            size_t otherMinCount = other.is_full() ? other._heap[0].count : 0;
+
+            std::vector<Item> items;
+            items.reserve(_heap.size() + other._heap.size());
+            for (const Item& item : _heap)
+            {
+                const size_t* otherPosition = other._positions.find(item.value);
+                items.push_back(otherPosition
+                    ? Item{ item.value, item.count + other._heap[*otherPosition].count, item.error + other._heap[*otherPosition].error }
+                    : Item{ item.value, item.count + otherMinCount, item.error + otherMinCount });
+            }
+
+            for (const Item& item : other._heap)
+            {
+                if (!_positions.find(item.value))
+                {
+                    items.push_back(Item{ item.value, item.count + minCount, item.error + minCount });
+                }
+            }
+
+            if (items.size() > _capacity)
+            {
+                std::nth_element(items.begin(), items.begin() + _capacity, items.end(), [](const Item& a, const Item& b) { return a.count > b.count; });
+                items.erase(items.begin() + _capacity, items.end());
+            }
+
+            _total += other._total;
+            _heap = std::move(items);
+            _positions = detail::HashTable<T, size_t, Hash>();
+            _positions.reserve(_capacity);
+
+            std::make_heap(_heap.begin(), _heap.end(), [](const Item& a, const Item& b) { return a.count > b.count; });
+            for (size_t i = 0; i < _heap.size(); ++i)
+            {
+                _positions.insert(_heap[i].value, i);
+            }
+        }
+
+        // Returns the tracked values, sorted by their estimated counts in descending order.
+        std::vector<Item> top() const
+        {
+            std::vector<Item> result = _heap;
+            std::sort(result.begin(), result.end(), [](const Item& a, const Item& b) { return a.count > b.count; });
+            return result;
+        }
+
+        // Returns the number of values inserted into the sketch.
+        size_t total() const
+        {
+            return _total;
+        }
+
+        // Returns the maximum number of tracked values.
+        size_t capacity() const
+        {
+            return _capacity;
+        }
+
+    private:
+        bool is_full() const
+        {
+            return _capacity != 0 && _heap.size() == _capacity;
+        }
+
+        // The tracked values are stored in a min-heap by count, and their positions in the heap are stored in a hash table.
+
+        void swap_items(size_t a, size_t b)
+        {
+            std::swap(_heap[a], _heap[b]);
+            *_positions.find(_heap[a].value) = a;
+            *_positions.find(_heap[b].value) = b;
+        }
+
+        void sift_up(size_t index)
+        {
+            while (index > 0)
+            {
+                size_t parent = (index - 1) / 2;
+                if (_heap[parent].count <= _heap[index].count)
+                {
+                    return;
+                }
+
+                swap_items(parent, index);
+                index = parent;
+            }
+        }
+
+        void sift_down(size_t index)
+        {
+            while (true)
+            {
+                size_t smallest = index;
+                size_t left = index * 2 + 1;
+                size_t right = left + 1;
+                if (left < _heap.size() && _heap[left].count < _heap[smallest].count)
+                {
+                    smallest = left;
+                }
+
+                if (right < _heap.size() && _heap[right].count < _heap[smallest].count)
+                {
+                    smallest = right;
+                }
+
+                if (smallest == index)
+                {
+                    return;
+                }
+
+                swap_items(index, smallest);
+                index = smallest;
+            }
+        }
+
+        size_t _capacity;
+        size_t _total;
+        std::vector<Item> _heap;
+        detail::HashTable<T, size_t, Hash> _positions;
+    };
+
+
+    //
+    // Iterator base class
+    //
+
+    // Forward declaration
+    template <typename ConcreteIterType, typename OutType>
+    struct DoubleEndedIterator;
+
+    // Base class for all iterators.
+    template <typename ConcreteIterType, typename OutType>
+    struct Iterator
+    {
+        friend struct DoubleEndedIterator<ConcreteIterType, OutType>;
+
+        Iterator() = default;
+        Iterator(const Iterator&) = default;
+        Iterator& operator=(const Iterator&) = default;
+
+        // Advances the iterator, and returns a pointer to the next value.
+        // Returns null if there are no more elements left in the iterator.
+        // The returned pointer becomes invalid if the iterator goes out of scope,
+        // or if the iterator is advanced again (by calling next()).
+        inline const OutType* next()
+        {
+            return concrete_iter()->next_impl();
+        }
+
+        // Advances the iterator to the first element which is not less than the given value, and returns a pointer to it (same as `next`).
+        // The iterator must be sorted in ascending order, and the elements are compared with the < and > operators.
+        // Returns null if there are no such elements left.
+        // If the current iterator is a random access iterator, then the smaller elements are skipped with galloping (exponential) search,
+        // which takes O(log(d)) comparisons for skipping d elements. Otherwise the elements are skipped one by one.
+        // This can be called repeatedly with increasing values, e.g. to intersect multiple sorted iterators with the leapfrog algorithm.
+        const OutType* skip_until_ge(const OutType& value)
+        {
+            return skip_until_by(value, detail::Comparison());
+        }
+
+        // Same as `skip_until_ge`, but the elements are compared with the provided comparer function, which is called with
+        // an element and the given value, and must return <0, 0 or >0 (same as for `is_sorted_by`).
+        // The iterator is advanced to the first element for which the comparer doesn't return <0.
+        template <typename Comparer>
+        const OutType* skip_until_by(const OutType& value, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            if constexpr (detail::IsRandomAccessIter<ConcreteIterType>::value)
+            {
+                detail::gallop(*concrete_iter(), [&](const OutType& element) { return comparer(element, value) < 0; });
+                return next();
+            }
+            else
+            {
+                while (const OutType* element = next())
+                {
+                    if (!(comparer(*element, value) < 0))
+                    {
+                        return element;
+                    }
+                }
+
+                return nullptr;
+            }
+        }
+
+        //
+        // Consumer functions
+        //
+
+        // Calls the provided callback on all remaining elements of the iterator.
+        template <typename Callback>
+        void for_each(const Callback& callback)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Callback, const OutType&>::check();
+
+            while (const OutType* value = next())
+            {
+                callback(*value);
+            }
+        }
+
+        // Transforms the iterator into a collection, e.g. an std::vector, std::string, std::set, etc.
+        template <typename Collection>
+        Collection collect()
+        {
+            Collection coll{ };
+            while (const OutType* value = next())
+            {
+                detail::add_to_collection(coll, *value);
+            }
+
+            return coll;
+        }
+
+        // Same as collect, but calls `reserve` on the collection before adding any elements to it.
+        template <typename Collection, typename SizeType = size_t>
+        Collection collect_with_size_hint(const SizeType& sizeHint)
+        {
+            Collection coll{ };
+            coll.reserve(sizeHint);
+
+            while (const OutType* value = next())
+            {
+                detail::add_to_collection(coll, *value);
+            }
+
+            return coll;
+        }
+
+        // Partitions the elements of the iterator based on the provided predicate callback.
+        // This function creates two collections - the first collection will contain all values which
+        // the predicate returned false for, the second will contain the rest (which the predicate returned true for).
+        template <typename Collection, typename Predicate>
+        std::pair<Collection, Collection> partition(const Predicate& predicate)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            std::pair<Collection, Collection> result = { };
+            Collection* collections[2] = { &result.first, &result.second };
+
+            for_each([&](const OutType& value)
+            {
+                detail::add_to_collection(*collections[predicate(value)], value);
+            });
+
+            return result;
+        }
+
+        // Reduces the iterator into a single value, by repeatedly calling the provided reducer function.
+        // The reducer function takes two parameters:
+        // The first parameter is the accumulator, which will contain the last value returned by the reducer function.
+        // (when it's first called, it will be the first element of the iterator)
+        // The second parameter is the current element of the iterator.
+        // The reducer function must return a value, which will be passed as the first parameter to the reducer function,
+        // or, for the last element, this value will be the result of the entire reduce operation.
+        // For empty iterators, an empty value is returned. In all other cases, a non-empty value will be returned.
+        template <typename ReduceFunction>
+        std::optional<OutType> reduce(const ReduceFunction& reduceFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<ReduceFunction, const OutType&, const OutType&>::check();
+
+            const OutType* first = next();
+            if (!first)
+            {
+                // no elements, return an empty value
+                return { };
+            }
+
+            OutType reduced = *first;
+            while (const OutType* value = next())
+            {
+                const OutType& reducedConst = reduced;
+                reduced = reduceFunction(reducedConst, *value);
+            }
+
+            return reduced;
+        }
+
+        // Similarly to `reduce`, this function also reduces the iterator to a single value,
+        // the difference is that `fold` takes an initial value, instead of using the first value in the iterator.
+        // Because of this, `fold` will always return a value. (If the iterator is empty, then the initial value is returned)
+        template <typename T, typename FoldFunction>
+        T fold(T initialValue, const FoldFunction& foldFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<FoldFunction, const T&, const OutType&>::check();
+
+            while (const OutType* value = next())
+            {
+                const T& currentValue = initialValue;
+                initialValue = foldFunction(currentValue, *value);
+            }
+
+            return initialValue;
+        }
+
+        // Consumes the iterator, and returns the number of elements in it.
+        template <typename T = size_t>
+        T count()
+        {
+            T count = T(0);
+
+            while (next())
+            {
+                ++count;
+            }
+
+            return count;
+        }
+
+        // Consumes the iterator, and returns its last element.
+        // If the iterator is empty, then an empty value is returned.
+        std::optional<OutType> last()
+        {
+            const OutType* first = next();
+            if (!first)
+            {
+                // no elements, return an empty value
+                return { };
+            }
+
+            OutType last = *first;
+            while (const OutType* value = next())
+            {
+                last = *value;
+            }
+
+            return last;
+        }
+
+        // Returns the element at the given index, by advancing the iterator idx + 1 times.
+        // If the iterator doesn't have enough elements, then an empty value is returned.
+        template <typename T>
+        std::optional<OutType> nth(const T& idx)
+        {
+            T currentIdx = T(0);
+            while (const OutType* value = next())
+            {
+                if (currentIdx++ == idx)
+                {
+                    return *value;
+                }
+            }
+
+            return { };
+        }
+
+        // Calls the provided predicate on all elements of the iterator, and checks if all returned values are true.
+        // The process will stop at the first false value, so this function might not fully consume the iterator.
+        // For empty iterators, this function returns true.
+        template <typename Predicate>
+        bool all(const Predicate& predicate)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            while (const OutType* value = next())
+            {
+                if (!predicate(*value))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Calls the provided predicate on all elements of the iterator, and checks if any of the returned values is true.
+        // The process will stop at the first true value, so this function might not fully consume the iterator.
+        // For empty iterators, this function returns false.
+        template <typename Predicate>
+        bool any(const Predicate& predicate)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            while (const OutType* value = next())
+            {
+                if (predicate(*value))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Advances the iterator until a value that satisfies the predicate is found.
+        // The process will stop at the first such value, so this function might not fully consume the iterator.
+        // If no element was found, then an empty value is returned.
+        template <typename Predicate>
+        std::optional<OutType> find(const Predicate& predicate)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            while (const OutType* value = next())
+            {
+                if (predicate(*value))
+                {
+                    return *value;
+                }
+            }
+
+            return { };
+        }
+
+        // Advances the iterator until a value that satisfies the predicate is found, and returns its index.
+        // The process will stop at the first such value, so this function might not fully consume the iterator.
+        // If no element was found, then an empty value is returned.
+        template <typename Predicate, typename Position = size_t>
+        std::optional<Position> position(const Predicate& predicate)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            Position pos = Position(0);
+            while (const OutType* value = next())
+            {
+                if (predicate(*value))
+                {
+                    return pos;
+                }
+
+                ++pos;
+            }
+
+            return { };
+        }
+
+        // Returns the number of leading elements for which the predicate returns true, and advances the iterator past them.
+        // The elements must be partitioned by the predicate: all elements for which it returns true must come before the others
+        // (e.g. `x < 5` for an iterator sorted in ascending order).
+        // If the current iterator is a random access iterator, then a binary search is used, which takes O(log(n)) time
+        // (and if it's contiguous, then a branchless version of it), and the next element is the first one for which the predicate returns false.
+        // Otherwise the elements are checked one by one (see `rusty::is_random_access_v`), and since an element can't be put back,
+        // the first element for which the predicate returns false is consumed too.
+        template <typename Predicate>
+        size_t partition_point(const Predicate& predicate)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            if constexpr (detail::IsRandomAccessIter<ConcreteIterType>::value)
+            {
+                return partition_point_random_access(predicate);
+            }
+            else
+            {
+                size_t count = 0;
+                while (const OutType* value = next())
+                {
+                    if (!predicate(*value))
+                    {
+                        break;
+                    }
+
+                    ++count;
+                }
+
+                return count;
+            }
+        }
+
+        // Searches for the given value in the iterator, which must be sorted in ascending order, comparing elements with the < and > operators.
+        // Returns the index of the first element which is equal to the value, or an empty optional if there is no such element.
+        // Uses `partition_point`, so it takes O(log(n)) time for random access iterators.
+        // Same as for `partition_point`, random access iterators are advanced to the first element which is not less than the value
+        // (the found element, if there is one), and other iterators are advanced past it.
+        std::optional<size_t> binary_search(const OutType& value)
+        {
+            return binary_search_by([&](const OutType& element) { return detail::compare(element, value); });
+        }
+
+        // Same as `binary_search`, but the elements are compared with the provided comparer function, which is called with
+        // an element, and must return <0 if the element is less than the searched one, 0 if it's equal, and >0 if it's greater.
+        // The iterator must be sorted by the comparer, so that all elements for which it returns <0 come first.
+        template <typename Comparer>
+        std::optional<size_t> binary_search_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&>::check();
+
+            if constexpr (detail::IsRandomAccessIter<ConcreteIterType>::value)
+            {
+                size_t index = partition_point_random_access([&](const OutType& element) { return comparer(element) < 0; });
+                const OutType* found = concrete_iter()->get(0);
+                if (found && comparer(*found) == 0)
+                {
+                    return index;
+                }
+
+                return { };
+            }
+            else
+            {
+                size_t index = 0;
+                while (const OutType* element = next())
+                {
+                    auto compared = comparer(*element);
+                    if (compared == 0)
+                    {
+                        return index;
+                    }
+
+                    if (compared > 0)
+                    {
+                        return { };
+                    }
+
+                    ++index;
+                }
+
+                return { };
+            }
+        }
+
+        // Returns the minimum value in the iterator, comparing elements with the < operator.
+        // If there are multiple minimum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        std::optional<OutType> min()
+        {
+            return min_by(detail::compare<OutType>);
+        }
+
+        // Returns the minimum value in the iterator, comparing elements with the provided comparer function.
+        // If there are multiple minimum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        template <typename Comparer>
+        std::optional<OutType> min_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            const OutType* first = next();
+            if (!first)
+            {
+                return { };
+            }
+
+            OutType minValue = *first;
+            while (const OutType* value = next())
+            {
+                const OutType& minValueConst = minValue;
+                if (comparer(*value, minValueConst) < 0)
+                {
+                    minValue = *value;
+                }
+            }
+
+            return minValue;
+        }
+
+        // Returns the maximum value in the iterator, comparing elements with the > operator.
+        // If there are multiple maximum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        std::optional<OutType> max()
+        {
+            return max_by(detail::compare<OutType>);
+        }
+
+        // Returns the maximum value in the iterator, comparing elements with the provided comparer function.
+        // If there are multiple maximum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        template <typename Comparer>
+        std::optional<OutType> max_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            const OutType* first = next();
+            if (!first)
+            {
+                return { };
+            }
+
+            OutType maxValue = *first;
+            while (const OutType* value = next())
+            {
+                const OutType& maxValueConst = maxValue;
+                if (comparer(*value, maxValueConst) > 0)
+                {
+                    maxValue = *value;
+                }
+            }
+
+            return maxValue;
+        }
+
+        // Returns both the minimum and the maximum value in the iterator, comparing elements with the < and > operators.
+        // If there are multiple minimum or maximum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        // For iterators created from contiguous collections of numbers, a loop which can be vectorized by the compiler is used.
+        std::optional<std::pair<OutType, OutType>> minmax()
+        {
+            if constexpr (detail::IsContiguousIter<ConcreteIterType>::value && std::is_arithmetic_v<OutType>)
+            {
+                Slice<OutType> remaining = concrete_iter()->as_slice();
+                if (remaining.empty())
+                {
+                    return { };
+                }
+
+                concrete_iter()->advance_by(remaining.size());
+
+                std::pair<OutType, OutType> result;
+                detail::minmax_contiguous(remaining.data(), remaining.size(), result.first, result.second);
+                return result;
+            }
+            else
+            {
+                return minmax_by(detail::compare<OutType>);
+            }
+        }
+
+        // Returns both the minimum and the maximum value in the iterator, comparing elements with the provided comparer function.
+        // The elements are processed in pairs: the two elements are compared with each other first, then the smaller one is compared
+        // with the minimum, and the larger one with the maximum, so only about 1.5 comparisons are needed per element.
+        // If there are multiple minimum or maximum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        template <typename Comparer>
+        std::optional<std::pair<OutType, OutType>> minmax_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            using Stored = detail::StoredValue<OutType, detail::HasStablePointers<ConcreteIterType>::value>;
+
+            const OutType* first = next();
+            if (!first)
+            {
+                return { };
+            }
+
+            Stored minValue;
+            Stored maxValue;
+            Stored pairFirst;
+            minValue.set(first);
+            maxValue.set(first);
+
+            while (const OutType* value = next())
+            {
+                // the value must be stored, because getting the next value may invalidate it
+                pairFirst.set(value);
+                const OutType* a = pairFirst.get();
+                const OutType* b = next();
+
+                const OutType* pairMin = a;
+                const OutType* pairMax = a;
+                if (b)
+                {
+                    auto compared = comparer(*b, *a);
+                    if (compared < 0)
+                    {
+                        pairMin = b;
+                    }
+                    else if (compared > 0)
+                    {
+                        pairMax = b;
+                    }
+                }
+
+                if (comparer(*pairMin, *minValue.get()) < 0)
+                {
+                    minValue.set(pairMin);
+                }
+
+                if (comparer(*pairMax, *maxValue.get()) > 0)
+                {
+                    maxValue.set(pairMax);
+                }
+
+                if (!b)
+                {
+                    break;
+                }
+            }
+
+            return std::make_pair(*minValue.get(), *maxValue.get());
+        }
+
+        // Returns the index and the value of the minimum element in the iterator, comparing elements with the < and > operators.
+        // If there are multiple minimum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        // For iterators created from contiguous collections of numbers, a loop which can be vectorized by the compiler is used.
+        template <typename Position = size_t>
+        std::optional<std::pair<Position, OutType>> position_min()
+        {
+            if constexpr (detail::IsContiguousIter<ConcreteIterType>::value && std::is_arithmetic_v<OutType>)
+            {
+                return position_extreme_contiguous<false, Position>();
+            }
+            else
+            {
+                return position_min_by<detail::Comparison, Position>(detail::Comparison());
+            }
+        }
+
+        // Returns the index and the value of the minimum element in the iterator, comparing elements with the provided comparer function.
+        // If there are multiple minimum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        template <typename Comparer, typename Position = size_t>
+        std::optional<std::pair<Position, OutType>> position_min_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return position_extreme_by<Position>([&](const OutType& a, const OutType& b) { return comparer(a, b) < 0; });
+        }
+
+        // Returns the index and the value of the maximum element in the iterator, comparing elements with the < and > operators.
+        // If there are multiple maximum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        // For iterators created from contiguous collections of numbers, a loop which can be vectorized by the compiler is used.
+        template <typename Position = size_t>
+        std::optional<std::pair<Position, OutType>> position_max()
+        {
+            if constexpr (detail::IsContiguousIter<ConcreteIterType>::value && std::is_arithmetic_v<OutType>)
+            {
+                return position_extreme_contiguous<true, Position>();
+            }
+            else
+            {
+                return position_max_by<detail::Comparison, Position>(detail::Comparison());
+            }
+        }
+
+        // Returns the index and the value of the maximum element in the iterator, comparing elements with the provided comparer function.
+        // If there are multiple maximum values, then the first one is returned.
+        // If the iterator is empty, then an empty value is returned.
+        template <typename Comparer, typename Position = size_t>
+        std::optional<std::pair<Position, OutType>> position_max_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return position_extreme_by<Position>([&](const OutType& a, const OutType& b) { return comparer(a, b) > 0; });
+        }
+
+        // Returns the k smallest elements of the iterator, in ascending order, comparing elements with the < and > operators.
+        // The elements are collected into a heap which contains at most k elements,
+        // so this function needs O(k) memory, and takes O(n * log(k)) time.
+        // If the iterator has less than k elements, then all elements are returned.
+        std::vector<OutType> k_smallest(size_t k)
+        {
+            return k_smallest_by(k, detail::compare<OutType>);
+        }
+
+        // Same as `k_smallest`, but the elements are compared with the provided comparer function.
+        template <typename Comparer>
+        std::vector<OutType> k_smallest_by(size_t k, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            std::vector<OutType> heap;
+            if (k == 0)
+            {
+                return heap;
+            }
+
+            if (std::optional<size_t> len = detail::known_len(*concrete_iter()))
+            {
+                heap.reserve(*len < k ? *len : k);
+            }
+
+            auto less = [&](const OutType& a, const OutType& b) { return comparer(a, b) < 0; };
+
+            // max-heap of the k smallest elements so far, the root is the greatest of them
+            while (const OutType* value = next())
+            {
+                if (heap.size() < k)
+                {
+                    heap.push_back(*value);
+                    std::push_heap(heap.begin(), heap.end(), less);
+                }
+                else if (less(*value, heap.front()))
+                {
+                    // replace the greatest element, and restore the heap with a single pass from the root
+                    heap.front() = *value;
+                    detail::sift_down_root(heap.data(), heap.size(), less);
+                }
+            }
+
+            std::sort_heap(heap.begin(), heap.end(), less);
+            return heap;
+        }
+
+        // Same as `k_smallest`, but the elements are compared by the keys returned by the provided key function.
+        template <typename KeyFunction>
+        std::vector<OutType> k_smallest_by_key(size_t k, const KeyFunction& keyFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::check();
+
+            return k_smallest_by_key_impl<false>(k, keyFunction);
+        }
+
+        // Returns the k largest elements of the iterator, in descending order, comparing elements with the < and > operators.
+        // Same as `k_smallest`, but with the comparison reversed.
+        std::vector<OutType> k_largest(size_t k)
+        {
+            return k_smallest_by(k, detail::compare_reverse<OutType>);
+        }
+
+        // Same as `k_largest`, but the elements are compared with the provided comparer function.
+        template <typename Comparer>
+        std::vector<OutType> k_largest_by(size_t k, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return k_smallest_by(k, [&](const OutType& a, const OutType& b) { return comparer(b, a); });
+        }
+
+        // Same as `k_largest`, but the elements are compared by the keys returned by the provided key function.
+        template <typename KeyFunction>
+        std::vector<OutType> k_largest_by_key(size_t k, const KeyFunction& keyFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::check();
+
+            return k_smallest_by_key_impl<true>(k, keyFunction);
+        }
+
+        // Returns the element which would be at index k (starting from 0) if the elements were sorted in ascending order,
+        // comparing elements with the < and > operators.
+        // Unlike `nth`, which returns the nth element in iteration order, this function collects all elements into a buffer,
+        // and uses introselect, which takes O(n) time on average, instead of sorting all elements.
+        // If the iterator has k or less elements, then an empty optional is returned.
+        std::optional<OutType> select_nth(size_t k)
+        {
+            return select_nth_by(k, detail::compare<OutType>);
+        }
+
+        // Same as `select_nth`, but the elements are compared with the provided comparer function.
+        template <typename Comparer>
+        std::optional<OutType> select_nth_by(size_t k, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            std::vector<OutType> buffer = collect_buffer();
+            return select_nth_in_buffer(buffer, k, comparer);
+        }
+
+        // Returns the median of the elements, comparing elements with the < and > operators.
+        // If the number of elements is even, then the lower one of the two middle elements is returned.
+        // Same as `select_nth((count - 1) / 2)`.
+        // If the iterator is empty, then an empty optional is returned.
+        std::optional<OutType> median()
+        {
+            return median_by(detail::compare<OutType>);
+        }
+
+        // Same as `median`, but the elements are compared with the provided comparer function.
+        template <typename Comparer>
+        std::optional<OutType> median_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            std::vector<OutType> buffer = collect_buffer();
+            if (buffer.empty())
+            {
+                return { };
+            }
+
+            return select_nth_in_buffer(buffer, (buffer.size() - 1) / 2, comparer);
+        }
+
+        // Returns the elements at the given quantiles (numbers between 0 and 1) of the elements, comparing elements with the < and > operators.
+        // The element at quantile q is the element at index floor(q * (count - 1)) of the sorted elements, so 0 is the minimum,
+        // 0.5 is the median (same as `median`), and 1 is the maximum. Quantiles outside of [0, 1] are clamped, and NaN is treated as 0.
+        // The returned elements are in the same order as the requested quantiles.
+        // All quantiles are selected in one pass, by recursively partitioning the buffered elements around the requested indices,
+        // which takes O(n * log(m)) time for m quantiles, instead of sorting all elements.
+        // If the iterator is empty, then an empty vector is returned.
+        std::vector<OutType> quantiles(const std::vector<double>& fractions)
+        {
+            return quantiles_by(fractions, detail::compare<OutType>);
+        }
+
+        // Same as `quantiles`, but the elements are compared with the provided comparer function.
+        template <typename Comparer>
+        std::vector<OutType> quantiles_by(const std::vector<double>& fractions, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            std::vector<OutType> buffer = collect_buffer();
+            std::vector<OutType> result;
+            if (buffer.empty())
+            {
+                return result;
+            }
+
+            std::vector<size_t> indices;
+            indices.reserve(fractions.size());
+            for (double fraction : fractions)
+            {
+                indices.push_back(static_cast<size_t>(detail::clamp_quantile(fraction) * static_cast<double>(buffer.size() - 1)));
+            }
+
+            std::vector<size_t> sortedIndices = indices;
+            std::sort(sortedIndices.begin(), sortedIndices.end());
+            sortedIndices.erase(std::unique(sortedIndices.begin(), sortedIndices.end()), sortedIndices.end());
+
+            detail::select_multiple(buffer.data(), 0, buffer.size(), sortedIndices.data(), sortedIndices.size(),
+                [&](const OutType& a, const OutType& b) { return comparer(a, b) < 0; });
+
+            result.reserve(indices.size());
+            for (size_t index : indices)
+            {
+                result.push_back(buffer[index]);
+            }
+
+            return result;
+        }
+
+        // Inserts all elements into a `QuantileSketch`, which estimates the quantiles of the elements with a fixed amount of memory.
+        // Unlike `quantiles`, this function doesn't need to buffer all elements, so it can be used for very long iterators.
+        // The rank of the estimated quantiles is within about epsilon * count of the requested rank with high probability.
+        // The returned sketch can be queried for any quantile, and it can be merged with other sketches.
+        QuantileSketch<OutType> approx_quantiles(double epsilon)
+        {
+            QuantileSketch<OutType> sketch(epsilon);
+            while (const OutType* value = next())
+            {
+                sketch.insert(*value);
+            }
+
+            return sketch;
+        }
+
+        // Inserts all elements into a `DistinctCountSketch`, which estimates the number of distinct elements with a fixed amount of memory (HyperLogLog).
+        // Unlike `unique().count()`, the memory usage doesn't depend on the number of distinct elements: the sketch uses 2^precision bytes,
+        // and the relative error of the estimate is about 1.04 / sqrt(2^precision).
+        // The elements are hashed with std::hash. The returned sketch can be merged with other sketches.
+        DistinctCountSketch<OutType> approx_count_distinct(unsigned precision = 14)
+        {
+            DistinctCountSketch<OutType> sketch(precision);
+            while (const OutType* value = next())
+            {
+                sketch.insert(*value);
+            }
+
+            return sketch;
+        }
+
+        // Computes the count, mean, variance, minimum and maximum of the elements in a single pass (see `Statistics`).
+        // If the current iterator was created from a contiguous collection of arithmetic values, then the elements are processed in blocks,
+        // with loops that the compiler can vectorize.
+        Statistics<OutType> stats()
+        {
+            Statistics<OutType> statistics;
+            if constexpr (detail::IsContiguousIter<ConcreteIterType>::value && std::is_arithmetic_v<OutType>)
+            {
+                Slice<OutType> remaining = concrete_iter()->as_slice();
+                concrete_iter()->advance_by(remaining.size());
+                statistics.insert_contiguous(remaining.data(), remaining.size());
+            }
+            else
+            {
+                while (const OutType* value = next())
+                {
+                    statistics.insert(*value);
+                }
+            }
+
+            return statistics;
+        }
+
+        // Inserts all elements into a `HeavyHittersSketch`, which finds the most frequent elements with O(k) memory (Space-Saving algorithm).
+        // Every element which occurs more than count / k times is guaranteed to be in the sketch, and the estimated counts are never too low.
+        // The elements are hashed with std::hash. The returned sketch can be merged with other sketches.
+        HeavyHittersSketch<OutType> heavy_hitters(size_t k)
+        {
+            HeavyHittersSketch<OutType> sketch(k);
+            while (const OutType* value = next())
+            {
+                sketch.insert(*value);
+            }
+
+            return sketch;
+        }
+
+        // Counts how many times each distinct element occurs in the iterator.
+        // Returns the distinct elements with their counts, in the order of their first occurrence.
+        // The elements are counted in an open-addressing hash table (using std::hash and the == operator),
+        // which is reserved up front if the number of elements is known.
+        std::vector<std::pair<OutType, size_t>> counts()
+        {
+            return counts_by(detail::Identity());
+        }
+
+        // Same as `counts`, but counts the keys returned by the provided key function, instead of the elements themselves.
+        template <typename KeyFunction>
+        auto counts_by(const KeyFunction& keyFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::check();
+
+            using KeyType = std::decay_t<typename detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::type>;
+
+            std::vector<std::pair<KeyType, size_t>> result;
+
+            // maps each key to its index in the result
+            detail::HashTable<KeyType, size_t> indices;
+            if (std::optional<size_t> len = detail::known_len(*concrete_iter()))
+            {
+                indices.reserve(*len);
+            }
+
+            while (const OutType* value = next())
+            {
+                decltype(auto) key = keyFunction(*value);
+                auto [index, inserted] = indices.insert(key, result.size());
+                if (inserted)
+                {
+                    result.emplace_back(key, 1);
+                }
+                else
+                {
+                    ++result[*index].second;
+                }
+            }
+
+            return result;
+        }
+
+        // Counts the elements in equal width bins between `low` and `high`, and returns the counts of the bins.
+        // Bin i contains the elements in [low + i * width, low + (i + 1) * width), where width = (high - low) / binCount.
+        // Elements outside of [low, high) are not counted. The counts are accumulated in a dense array, so no hashing is needed.
+        // If `binCount` is 0, or `high` is not greater than `low`, then an empty vector is returned. The iterator is consumed in every case.
+        std::vector<size_t> histogram(double low, double high, size_t binCount)
+        {
+            static_assert(std::is_arithmetic_v<OutType>, "histogram requires arithmetic elements.");
+
+            std::vector<size_t> bins;
+            if (binCount == 0 || !(high > low))
+            {
+                // consume the iterator anyway, so that it is in the same state as with valid bins
+                while (next())
+                {
+                }
+
+                return bins;
+            }
+
+            bins.resize(binCount, 0);
+            double scale = static_cast<double>(binCount) / (high - low);
+            while (const OutType* value = next())
+            {
+                double x = static_cast<double>(*value);
+                if (x >= low && x < high)
+                {
+                    size_t bin = static_cast<size_t>((x - low) * scale);
+
+                    // rounding errors could put values near the end into a non-existent bin
+                    ++bins[bin < binCount ? bin : binCount - 1];
+                }
+            }
+
+            return bins;
+        }
+
+        // Returns the sum of all elements in the iterator, by adding all elements together.
+        // If the iterator is empty, then 0 is returned.
+        template <typename T = OutType>
+        T sum()
+        {
+            T sum = T(0);
+
+            while (const OutType* value = next())
+            {
+                sum += *value;
+            }
+
+            return sum;
+        }
+
+        // Returns the product of all elements in the iterator, by multiplying all elements together.
+        // If the iterator is empty, then 1 is returned.
+        template <typename T = OutType>
+        T product()
+        {
+            T product = T(1);
+
+            while (const OutType* value = next())
+            {
+                product *= *value;
+            }
+
+            return product;
+        }
+
+        // Returns true if the iterator is sorted ascending, so that no element is less than the previous one.
+        // The process will stop when a non-sorted pair is encountered, so this function might not fully consume the iterator.
+        // For iterators with less than 2 elements, this function always returns true.
+        bool is_sorted_ascending()
+        {
+            return is_sorted_by(detail::compare<OutType>);
+        }
+
+        // Returns true if the iterator is sorted descending, so that no element is greater than the previous one.
+        // The process will stop when a non-sorted pair is encountered, so this function might not fully consume the iterator.
+        // For iterators with less than 2 elements, this function always returns true.
+        bool is_sorted_descending()
+        {
+            return is_sorted_by(detail::compare_reverse<OutType>);
+        }
+
+        // Returns true if the iterator is sorted by the given comparer.
+        // The comparer function must return:
+        // - a negative value if the first compared value is less than the second,
+        // - a positive value if the first compared value is greater than the second,
+        // - zero if they are equal
+        // The process will stop when a non-sorted pair is encountered, so this function might not fully consume the iterator.
+        // For iterators with less than 2 elements, this function always returns true.
+        template <typename Comparer>
+        bool is_sorted_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            const OutType* first = next();
+            if (!first)
+            {
+                // no elements, return true
+                return true;
+            }
+
+            OutType prev = *first;
+            while (const OutType* value = next())
+            {
+                const OutType& prevConst = prev;
+                if (comparer(prevConst, *value) > 0)
+                {
+                    // not sorted, return false immediately
+                    return false;
+                }
+
+                prev = *value;
+            }
+
+            return true;
+        }
+
+        //
+        // Comparison functions
+        //
+
+        // Lexicographically compares the elements of this iterator with another iterator's elements, using the provided comparison function.
+        // The comparison function must be a partial comparer, which means that it can return an empty value if the elements cannot be compared.
+        // If the elements can be compared, then the usual <0, 0, and >0 must be returned.
+        // Returns -1 if this iterator is less than the other iterator, 0 if they are equal, and 1 if this iterator is greater than the other iterator.
+        // Returns an empty value if there was at least one pair of elements that could not be compared.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType, typename PartialComparisonFunction>
+        std::optional<char> partial_cmp_by(OtherIterType&& other, const PartialComparisonFunction& partialComparisonFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<PartialComparisonFunction, const OutType&, const OutType&>::check();
+
+            while (true)
+            {
+                const OutType* thisValue = next();
+                const OutType* otherValue = other.next();
+
+                if (!thisValue)
+                {
+                    if (otherValue)
+                    {
+                        // current iterator has finished before the other, so this < other
+                        return -1;
+                    }
+                    else
+                    {
+                        // both iterators have finished at the same time, so this == other
+                        return 0;
+                    }
+                }
+
+                if (!otherValue)
+                {
+                    // other iterator has finished before the current, so this > other
+                    return 1;
+                }
+
+                // none of the iterators have finished yet, compare the values
+                std::optional<char> compared = partialComparisonFunction(*thisValue, *otherValue);
+                if (!compared || *compared != 0)
+                {
+                    // values are different or cannot be compared, return the result
+                    return compared;
+                }
+                else
+                {
+                    // values are equal, check the next ones
+                }
+            }
+        }
+
+        // Lexicographically compares the elements of this iterator with another iterator's elements, using the provided comparison function.
+        // Returns -1 if this iterator is less than the other iterator, 0 if they are equal, and 1 if this iterator is greater than the other iterator.
+        // Returns an empty value if there was at least one pair of elements that could not be compared.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType>
+        std::optional<char> partial_cmp(OtherIterType&& other)
+        {
+            return partial_cmp_by(other, detail::compare_partial<OutType>);
+        }
+
+        // Lexicographically compares the elements of this iterator with another iterator's elements, using the provided comparison function.
+        // Returns -1 if this iterator is less than the other iterator, 0 if they are equal, and 1 if this iterator is greater than the other iterator.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType, typename ComparisonFunction>
+        char cmp_by(OtherIterType&& other, const ComparisonFunction& comparisonFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<ComparisonFunction, const OutType&, const OutType&>::check();
+
+            auto partialComparisonFunction = [&](const OutType& a, const OutType& b) -> std::optional<OutType>
+            {
+                return comparisonFunction(a, b);
+            };
+
+            // we always return a non-empty value in our comparer, so we can just get the value
+            return *partial_cmp_by(other, partialComparisonFunction);
+        }
+
+        // Lexicographically compares the elements of this iterator with another iterator's elements.
+        // Returns -1 if this iterator is less than the other iterator, 0 if they are equal, and 1 if this iterator is greater than the other iterator.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType>
+        char cmp(OtherIterType&& other)
+        {
+            return cmp_by(other, detail::compare<OutType>);
+        }
+
+        // Determines if the elements of this iterator are equal to the elements of another iterator, using the provided equality comparer function.
+        // Returns true only if both iterators have the same number of elements, and all elements are equal.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType, typename EqualityComparerFunction>
+        bool eq_by(OtherIterType&& other, const EqualityComparerFunction& equalityComparerFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<EqualityComparerFunction, const OutType&, const OutType&>::check();
+
+            while (true)
+            {
+                const OutType* thisValue = next();
+                const OutType* otherValue = other.next();
+
+                if (!thisValue)
+                {
+                    // this iterator has finished, the two iterators can only be equal if the other iterator has finished too
+                    return !otherValue;
+                }
+
+                if (!otherValue)
+                {
+                    // other iterator has finished before the current, so they cannot be equal
+                    return false;
+                }
+
+                // none of the iterators have finished yet, check equality
+                if (!equalityComparerFunction(*thisValue, *otherValue))
+                {
+                    // values are different
+                    return false;
+                }
+                else
+                {
+                    // values are equal, check the next ones
+                }
+            }
+        }
+
+        // Determines if the elements of this iterator are equal to the elements of another iterator.
+        // Returns true only if both iterators have the same number of elements, and all elements are equal.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType>
+        bool eq(OtherIterType&& other)
+        {
+            return eq_by(other, [](const OutType& a, const OutType& b) { return a == b; });
+        }
+
+        // Determines if the elements of this iterator are not equal to the elements of another iterator.
+        // Returns true if the iterators have a different number of elements, or if there is at least one pair of elements that are different.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType>
+        bool ne(OtherIterType&& other)
+        {
+            return !eq(other);
+        }
+
+        // Lexicographically compares the elements of this iterator with another iterator's elements.
+        // Returns true if this iterator is less than the other iterator, false otherwise.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType>
+        bool lt(OtherIterType&& other)
+        {
+            std::optional<char> cmp = partial_cmp(other);
+            return cmp && *cmp < 0;
+        }
+
+        // Lexicographically compares the elements of this iterator with another iterator's elements.
+        // Returns true if this iterator is less than or equal to the other iterator, false otherwise.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType>
+        bool le(OtherIterType&& other)
+        {
+            std::optional<char> cmp = partial_cmp(other);
+            return cmp && *cmp <= 0;
+        }
+
+        // Lexicographically compares the elements of this iterator with another iterator's elements.
+        // Returns true if this iterator is greater than the other iterator, false otherwise.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType>
+        bool gt(OtherIterType&& other)
+        {
+            std::optional<char> cmp = partial_cmp(other);
+            return cmp && *cmp > 0;
+        }
+
+        // Lexicographically compares the elements of this iterator with another iterator's elements.
+        // Returns true if this iterator is greater than or equal to the other iterator, false otherwise.
+        // Both iterators are advanced until their value becomes different, or until either of them has no more elements left.
+        template <typename OtherIterType>
+        bool ge(OtherIterType&& other)
+        {
+            std::optional<char> cmp = partial_cmp(other);
+            return cmp && *cmp >= 0;
+        }
+
+        //
+        // Iterator functions
+        //
+
+        // Creates an iterator that steps multiple times with each iteration, by the given step amount.
+        // Using 1 as the step value will produce identical behavior to the original iterator.
+        // Using step values that are less than 1 are invalid, and will create an empty iterator.
+        template <typename T>
+        detail::StepByIter<ConcreteIterType, T> step_by(const T& stepSize)
+        {
+            return detail::StepByIter<ConcreteIterType, T>(*concrete_iter(), stepSize);
+        }
+
+        // Appends an iterator to the end of the current iterator.
+        // This new iterator will yield elements from the first iterator until it finishes, then from the second iterator.
+        template <typename ChainedIterType>
+        detail::ChainIter<ConcreteIterType, ChainedIterType> chain(const ChainedIterType& chainedIter)
+        {
+            return detail::ChainIter<ConcreteIterType, ChainedIterType>(*concrete_iter(), chainedIter);
+        }
+
+        // Creates an iterator that iterates over two iterators in parallel.
+        // This new iterator will yield a pair of elements,
+        // the first element is from the first iterator, the second element is from the second.
+        // This iterator will stop yielding elements when any of the iterators are finished.
+        template <typename ZippedIterType>
+        detail::ZipIter<ConcreteIterType, ZippedIterType> zip(const ZippedIterType& zippedIter)
+        {
+            return detail::ZipIter<ConcreteIterType, ZippedIterType>(*concrete_iter(), zippedIter);
+        }
+
+        // Merges two sorted iterators into one sorted iterator, comparing elements with the < and > operators.
+        // If both iterators are sorted ascending, then the new iterator is also sorted ascending.
+        // Equal elements are yielded from the current iterator first, so the merge is stable.
+        template <typename OtherIterType>
+        detail::MergeIter<ConcreteIterType, OtherIterType, detail::Comparison> merge(const OtherIterType& other)
+        {
+            return detail::MergeIter<ConcreteIterType, OtherIterType, detail::Comparison>(*concrete_iter(), other, detail::Comparison());
+        }
+
+        // Same as `merge`, but the elements are compared with the provided comparer function.
+        // Both iterators must be sorted by the same comparer function.
+        template <typename OtherIterType, typename Comparer>
+        detail::MergeIter<ConcreteIterType, OtherIterType, Comparer> merge_by(const OtherIterType& other, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return detail::MergeIter<ConcreteIterType, OtherIterType, Comparer>(*concrete_iter(), other, comparer);
+        }
+
+        // Creates an iterator that yields the pairs of elements from the current and the other iterator which have equal keys (an inner join).
+        // The keys are returned by the provided key functions, and they are compared with std::hash and the == operator.
+        // The elements of one iterator are collected into a hash table (the smaller one, if both lengths are known, otherwise the other iterator),
+        // then the elements of the other iterator are looked up lazily, one by one. The pairs are yielded in the order of the probed iterator,
+        // and the matches of the same element are yielded in the order of the collected iterator.
+        // The pairs contain references: the elements of the collected iterator are owned by the join iterator,
+        // and the elements of the probed iterator stay valid until the join iterator is advanced to the next probed element.
+        template <typename OtherIterType, typename KeyFunction, typename OtherKeyFunction>
+        detail::HashJoinIter<ConcreteIterType, OtherIterType, KeyFunction, OtherKeyFunction> hash_join(
+            const OtherIterType& other, const KeyFunction& keyFunction, const OtherKeyFunction& otherKeyFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::check()
+                && detail::ReturnTypeHelperConstRefOrValue<OtherKeyFunction, const typename OtherIterType::OutType&>::check();
+
+            return detail::HashJoinIter<ConcreteIterType, OtherIterType, KeyFunction, OtherKeyFunction>(*concrete_iter(), other, keyFunction, otherKeyFunction);
+        }
+
+        // Creates an iterator that yields the pairs of elements from the current and the other iterator which are equal
+        // according to the provided comparer function (an inner join). Both iterators must be sorted by the comparer.
+        // The comparer is called with an element of the current iterator and an element of the other iterator, and it must return
+        // <0, 0 or >0, same as for `is_sorted_by`.
+        // No elements are collected, both iterators are advanced in place, and each element is only read once,
+        // except when multiple elements of the current iterator match the same elements of the other iterator:
+        // a copy of the other iterator is saved at the start of each matching run, and the run is iterated again from it.
+        // This way, only O(1) extra memory is needed.
+        // The pairs contain references, which stay valid until the join iterator is advanced.
+        template <typename OtherIterType, typename Comparer>
+        detail::MergeJoinIter<ConcreteIterType, OtherIterType, Comparer> merge_join(const OtherIterType& other, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const typename OtherIterType::OutType&>::check();
+
+            return detail::MergeJoinIter<ConcreteIterType, OtherIterType, Comparer>(*concrete_iter(), other, comparer);
+        }
+
+        // Creates an iterator that yields the elements which are in both the current and the other iterator.
+        // Both iterators must be sorted in ascending order, and the elements are compared with the < and > operators.
+        // Duplicates are handled like in std::set_intersection: if an element occurs m times in the current iterator
+        // and n times in the other one, then it's yielded min(m, n) times.
+        // If an iterator is a random access iterator (e.g. created from a vector), then runs of its elements which can't match
+        // are skipped with galloping search, which is much faster when one of the iterators is much smaller than the other one.
+        template <typename OtherIterType>
+        detail::SetOperationIter<ConcreteIterType, OtherIterType, detail::Comparison, detail::SetOperation::Intersection> intersect(const OtherIterType& other)
+        {
+            return detail::SetOperationIter<ConcreteIterType, OtherIterType, detail::Comparison, detail::SetOperation::Intersection>(*concrete_iter(), other, detail::Comparison());
+        }
+
+        // Same as `intersect`, but the elements are compared with the provided comparer function.
+        template <typename OtherIterType, typename Comparer>
+        detail::SetOperationIter<ConcreteIterType, OtherIterType, Comparer, detail::SetOperation::Intersection> intersect_by(const OtherIterType& other, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return detail::SetOperationIter<ConcreteIterType, OtherIterType, Comparer, detail::SetOperation::Intersection>(*concrete_iter(), other, comparer);
+        }
+
+        // Creates an iterator that yields the elements which are in the current or the other iterator, in ascending order.
+        // Both iterators must be sorted in ascending order, and the elements are compared with the < and > operators.
+        // Duplicates are handled like in std::set_union: if an element occurs m times in the current iterator
+        // and n times in the other one, then it's yielded max(m, n) times. Equal elements are yielded from the current iterator.
+        template <typename OtherIterType>
+        detail::SetOperationIter<ConcreteIterType, OtherIterType, detail::Comparison, detail::SetOperation::Union> union_sorted(const OtherIterType& other)
+        {
+            return detail::SetOperationIter<ConcreteIterType, OtherIterType, detail::Comparison, detail::SetOperation::Union>(*concrete_iter(), other, detail::Comparison());
+        }
+
+        // Same as `union_sorted`, but the elements are compared with the provided comparer function.
+        template <typename OtherIterType, typename Comparer>
+        detail::SetOperationIter<ConcreteIterType, OtherIterType, Comparer, detail::SetOperation::Union> union_sorted_by(const OtherIterType& other, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return detail::SetOperationIter<ConcreteIterType, OtherIterType, Comparer, detail::SetOperation::Union>(*concrete_iter(), other, comparer);
+        }
+
+        // Creates an iterator that yields the elements of the current iterator which are not in the other iterator.
+        // Both iterators must be sorted in ascending order, and the elements are compared with the < and > operators.
+        // Duplicates are handled like in std::set_difference: if an element occurs m times in the current iterator
+        // and n times in the other one, then it's yielded max(m - n, 0) times.
+        // If the other iterator is a random access iterator, then runs of its elements which can't match are skipped with galloping search.
+        template <typename OtherIterType>
+        detail::SetOperationIter<ConcreteIterType, OtherIterType, detail::Comparison, detail::SetOperation::Difference> difference(const OtherIterType& other)
+        {
+            return detail::SetOperationIter<ConcreteIterType, OtherIterType, detail::Comparison, detail::SetOperation::Difference>(*concrete_iter(), other, detail::Comparison());
+        }
+
+        // Same as `difference`, but the elements are compared with the provided comparer function.
+        template <typename OtherIterType, typename Comparer>
+        detail::SetOperationIter<ConcreteIterType, OtherIterType, Comparer, detail::SetOperation::Difference> difference_by(const OtherIterType& other, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return detail::SetOperationIter<ConcreteIterType, OtherIterType, Comparer, detail::SetOperation::Difference>(*concrete_iter(), other, comparer);
+        }
+
+        // Creates an iterator that yields the elements which are in exactly one of the current and the other iterator, in ascending order.
+        // Both iterators must be sorted in ascending order, and the elements are compared with the < and > operators.
+        // Duplicates are handled like in std::set_symmetric_difference: if an element occurs m times in the current iterator
+        // and n times in the other one, then it's yielded |m - n| times.
+        template <typename OtherIterType>
+        detail::SetOperationIter<ConcreteIterType, OtherIterType, detail::Comparison, detail::SetOperation::SymmetricDifference> sym_difference(const OtherIterType& other)
+        {
+            return detail::SetOperationIter<ConcreteIterType, OtherIterType, detail::Comparison, detail::SetOperation::SymmetricDifference>(*concrete_iter(), other, detail::Comparison());
+        }
+
+        // Same as `sym_difference`, but the elements are compared with the provided comparer function.
+        template <typename OtherIterType, typename Comparer>
+        detail::SetOperationIter<ConcreteIterType, OtherIterType, Comparer, detail::SetOperation::SymmetricDifference> sym_difference_by(const OtherIterType& other, const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return detail::SetOperationIter<ConcreteIterType, OtherIterType, Comparer, detail::SetOperation::SymmetricDifference>(*concrete_iter(), other, comparer);
+        }
+
+        // Creates an iterator that yields elements from the current and the other iterator alternately, starting with the current one.
+        // When one of them is finished, the remaining elements of the other one are yielded.
+        template <typename OtherIterType>
+        detail::InterleaveIter<ConcreteIterType, OtherIterType> interleave(const OtherIterType& other)
+        {
+            return detail::InterleaveIter<ConcreteIterType, OtherIterType>(*concrete_iter(), other);
+        }
+
+        // Creates an iterator that inserts a separator value between each element.
+        // The separator will not be inserted before the first element, nor after the last element.
+        detail::IntersperseWithIter<ConcreteIterType, detail::Getter<OutType>> intersperse(const OutType& separator)
+        {
+            return detail::IntersperseWithIter<ConcreteIterType, detail::Getter<OutType>>(*concrete_iter(), detail::Getter<OutType>(separator));
+        }
+
+        // Creates an iterator that inserts a separator value between each element.
+        // The current separator value is obtained by calling the provided separatorGetter function.
+        // The separator will not be inserted before the first element, nor after the last element.
+        template <typename SeparatorGetter>
+        detail::IntersperseWithIter<ConcreteIterType, SeparatorGetter> intersperse_with(const SeparatorGetter& separatorGetter)
+        {
+            return detail::IntersperseWithIter<ConcreteIterType, SeparatorGetter>(*concrete_iter(), separatorGetter);
+        }
+
+        // Transforms all values in the iterator, replacing each element with a new one.
+        // The provided map function takes the old value, and returns the new value.
+        // The old and the new values can have different types.
+        template <typename MapFunction>
+        detail::MapIter<ConcreteIterType, MapFunction> map(const MapFunction& mapFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<MapFunction, const OutType&>::check();
+
+            return detail::MapIter<ConcreteIterType, MapFunction>(*concrete_iter(), mapFunction);
+        }
+
+        // Creates an iterator that only yields elements that satisfy the filter function.
+        // Elements that the filter function returns false for are skipped, the rest are kept.
+        template <typename FilterFunction>
+        detail::FilterIter<ConcreteIterType, FilterFunction> filter(const FilterFunction& filterFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<FilterFunction, const OutType&>::check();
+
+            return detail::FilterIter<ConcreteIterType, FilterFunction>(*concrete_iter(), filterFunction);
+        }
+
+        // Creates an iterator that filters and maps at the same time.
+        // The provided filterMap function takes the old value, and must return a non-empty std::optional value
+        // if the current element should be kept (and transformed),
+        // and must return an empty value if the element should be skipped.
+        template <typename FilterMapFunction>
+        detail::FilterMapIter<ConcreteIterType, FilterMapFunction> filter_map(const FilterMapFunction& filterMapFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<FilterMapFunction, const OutType&>::check();
+
+            return detail::FilterMapIter<ConcreteIterType, FilterMapFunction>(*concrete_iter(), filterMapFunction);
+        }
+
+        // Creates an iterator which has an extra `peek` function, which allows you
+        // to retrieve the next value in the iterator without advancing the current iterator.
+        // Note that the underlying iterator is still advanced to get the next value when `peek` is called.
+        detail::PeekableIter<ConcreteIterType> peekable()
+        {
+            return detail::PeekableIter<ConcreteIterType>(*concrete_iter());
+        }
+
+        // Creates an iterator that skips elements while the given predicate returns true.
+        // When the predicate returns false for the first time, then no more items will be skipped.
+        template <typename Predicate>
+        detail::SkipWhileIter<ConcreteIterType, Predicate> skip_while(const Predicate& pred)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            return detail::SkipWhileIter<ConcreteIterType, Predicate>(*concrete_iter(), pred);
+        }
+
+        // Creates an iterator that yields elements only while the given predicate returns true.
+        // When the predicate returns false for the first time, then the rest of the elements are skipped.
+        template <typename Predicate>
+        detail::TakeWhileIter<ConcreteIterType, Predicate> take_while(const Predicate& pred)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            return detail::TakeWhileIter<ConcreteIterType, Predicate>(*concrete_iter(), pred);
+        }
+
+        // Creates an iterator that both yields elements based on a predicate and maps them, similarly to `take_while` and `map` combined.
+        // The provided mapWhile function takes the old value, and must return a non-empty std::optional value with the new value
+        // if the iteration should continue, and an empty value if the iteration should stop.
+        // The mapWhile function is called only once for each element, and it's not called again after it returned an empty value.
+        template <typename MapWhileFunction>
+        detail::MapWhileIter<ConcreteIterType, MapWhileFunction> map_while(const MapWhileFunction& mapWhileFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<MapWhileFunction, const OutType&>::check();
+
+            return detail::MapWhileIter<ConcreteIterType, MapWhileFunction>(*concrete_iter(), mapWhileFunction);
+        }
+
+        // Creates an iterator which skips the given number of elements,
+        // by advancing the underlying iterator that many times.
+        // If the underlying iterator is too short, then this function creates an empty iterator.
+        template <typename T = size_t>
+        detail::SkipWhileIter<ConcreteIterType, detail::Counter<T>> skip(const T& count)
+        {
+            return detail::SkipWhileIter<ConcreteIterType, detail::Counter<T>>(*concrete_iter(), detail::Counter<T>(count));
+        }
+
+        // Creates an iterator which yields the given number of elements at most.
+        // If the underlying iterator is too short, then less elements will be yielded.
+        template <typename T = size_t>
+        detail::TakeWhileIter<ConcreteIterType, detail::Counter<T>> take(const T& count)
+        {
+            return detail::TakeWhileIter<ConcreteIterType, detail::Counter<T>>(*concrete_iter(), detail::Counter<T>(count));
+        }
+
+        // Creates an iterator which yields the current element as well as its index in the current iterator.
+        // The new iterator returns pairs, where the first element is the index, and the second element is the value.
+        template <typename T = size_t>
+        detail::ZipIter<detail::GeneratorIter<detail::InfiniteRangeGenerator<T>>, ConcreteIterType> enumerate()
+        {
+            using Generator = detail::InfiniteRangeGenerator<T>;
+            using GeneratorIterType = detail::GeneratorIter<Generator>;
+            return detail::ZipIter<GeneratorIterType, ConcreteIterType>(GeneratorIterType(Generator(0, 1)), *concrete_iter());
+        }
+
+        // Creates an iterator from an iterator of iterators, which removes one level of nesting.
+        // Note that this function can only be called on nested iterators.
+        detail::FlattenIter<ConcreteIterType> flatten()
+        {
+            return detail::FlattenIter<ConcreteIterType>(*concrete_iter());
+        }
+
+        // Creates an iterator that will call the provided inspect function on each value before yielding them.
+        // The inspect function cannot change those values, only read (inspect) them.
+        // This function can be useful for debugging.
+        template <typename InspectFunction>
+        detail::InspectIter<ConcreteIterType, InspectFunction> inspect(const InspectFunction& inspectFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<InspectFunction, const OutType&>::check();
+
+            return detail::InspectIter<ConcreteIterType, InspectFunction>(*concrete_iter(), inspectFunction);
+        }
+
+        // Creates an iterator that repeats the current iterator endlessly.
+        // When that iterator is finshed, it will start again at the beginning, instead of finishing.
+        // If the current iterator is empty, then the cycled iterator will also be empty.
+        detail::CycleIter<ConcreteIterType> cycle()
+        {
+            return detail::CycleIter<ConcreteIterType>(*concrete_iter());
+        }
+
+        // Creates an iterator that yields every pair of an element of the current iterator and an element of the other iterator.
+        // For each element of the current iterator, all elements of the other iterator are yielded, in order.
+        // The other iterator is collected into a buffer once (instead of copying and re-running it for each element, like `cycle` does).
+        // The pairs contain references: the elements of the other iterator are owned by the product iterator,
+        // and the elements of the current iterator stay valid until the product iterator moves on to the next one.
+        template <typename OtherIterType>
+        detail::CartesianProductIter<ConcreteIterType, OtherIterType> cartesian_product(const OtherIterType& other)
+        {
+            return detail::CartesianProductIter<ConcreteIterType, OtherIterType>(*concrete_iter(), other);
+        }
+
+        // Creates an iterator that yields all combinations of k elements of the current iterator, in lexicographic order of their positions
+        // (elements at different positions are treated as distinct, even if they are equal).
+        // The elements are collected into a buffer once, then each combination is generated from an array of indices.
+        // The combinations are yielded as vectors of references (std::reference_wrapper) to the buffered elements.
+        // If k is 0, then one empty combination is yielded. If k is greater than the number of elements, then nothing is yielded.
+        // The exact number of remaining combinations can be queried with `len`.
+        detail::CombinationsIter<ConcreteIterType> combinations(size_t k)
+        {
+            return detail::CombinationsIter<ConcreteIterType>(*concrete_iter(), k);
+        }
+
+        // Creates an iterator that yields all permutations of k elements of the current iterator (all ordered selections of k distinct positions),
+        // in lexicographic order of their positions.
+        // Same as `combinations`, the elements are collected into a buffer once, and the permutations are yielded as vectors of references,
+        // generated from an array of indices. The exact number of remaining permutations can be queried with `len`.
+        detail::PermutationsIter<ConcreteIterType> permutations(size_t k)
+        {
+            return detail::PermutationsIter<ConcreteIterType>(*concrete_iter(), k);
+        }
+
+        // Splits the current iterator into N iterators, which all yield the same elements, but they can be advanced independently.
+        // The current iterator is only run once: the returned iterators share it, and the elements are buffered
+        // only while at least one of the iterators lags behind the others (if the current iterator has stable pointers,
+        // e.g. it was created from a collection, then only pointers to the elements are buffered).
+        // Copying one of the returned iterators doesn't create an independent iterator, because the copy shares its position,
+        // so each of them should be used only once (e.g. by calling a consumer function, or creating an adapter from it).
+        // An iterator which is never advanced makes every element buffered.
+        template <size_t N = 2>
+        std::array<detail::TeeIter<ConcreteIterType, N>, N> tee()
+        {
+            static_assert(N > 0, "tee must create at least one iterator.");
+
+            auto state = std::make_shared<typename detail::TeeIter<ConcreteIterType, N>::State>(*concrete_iter());
+            return detail::TeeIter<ConcreteIterType, N>::create_all(state, std::make_index_sequence<N>());
+        }
+
+        // Creates an iterator that yields the elements in ascending order, comparing them with the < and > operators.
+        // When the first element is requested, all elements are collected into a buffer, then the buffer is sorted incrementally,
+        // only as much as needed to yield the next element (using incremental quicksort).
+        // This way, getting the first k elements takes about O(n + k * log(k)) time, instead of sorting all n elements.
+        // Bad pivots are detected by limiting the number of partitions (same as for introselect), so the worst case is O(n * log(n)).
+        // The sort is not stable, so the order of equal elements is unspecified.
+        detail::SortedLazyIter<ConcreteIterType, detail::Comparison> sorted_lazy()
+        {
+            return detail::SortedLazyIter<ConcreteIterType, detail::Comparison>(*concrete_iter(), detail::Comparison());
+        }
+
+        // Same as `sorted_lazy`, but the elements are compared with the provided comparer function.
+        template <typename Comparer>
+        detail::SortedLazyIter<ConcreteIterType, Comparer> sorted_lazy_by(const Comparer& comparer)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const OutType&, const OutType&>::check();
+
+            return detail::SortedLazyIter<ConcreteIterType, Comparer>(*concrete_iter(), comparer);
+        }
+
+        // Creates an iterator which always returns null after the current iterator returned null for the first time.
+        // If the current iterator is already fused (e.g. iterators created from collections, ranges, or `take_while`),
+        // then a copy of the current iterator is returned, so there is no additional cost.
+        std::conditional_t<detail::IsFusedIter<ConcreteIterType>::value, ConcreteIterType, detail::FuseIter<ConcreteIterType>> fuse()
+        {
+            return *concrete_iter();
+        }
+
+        // Creates an iterator that yields the elements in chunks of the given size, as `rusty::Slice` values.
+        // The last chunk is shorter if the number of elements is not divisible by the chunk size.
+        // If the current iterator was created from a contiguous collection (e.g. std::vector, std::string or pointers),
+        // then the slices point directly into that collection, and no elements are copied.
+        // Otherwise, the elements are copied into a buffer, which is reused for every chunk.
+        // Using 0 as the chunk size will create an empty iterator.
+        detail::ChunksIter<ConcreteIterType, false> chunks(size_t chunkSize)
+        {
+            return detail::ChunksIter<ConcreteIterType, false>(*concrete_iter(), chunkSize);
+        }
+
+        // Same as `chunks`, but all yielded chunks have exactly the given size.
+        // The elements at the end which don't fill a whole chunk are not yielded,
+        // they can be retrieved by calling `remainder` on the iterator after it has finished.
+        detail::ChunksIter<ConcreteIterType, true> chunks_exact(size_t chunkSize)
+        {
+            return detail::ChunksIter<ConcreteIterType, true>(*concrete_iter(), chunkSize);
+        }
+
+        // Creates an iterator that yields all overlapping windows of the given size, as `rusty::Slice` values.
+        // Each window starts one element after the previous one. If there are fewer elements than the window size,
+        // then no windows are yielded.
+        // If the current iterator was created from a contiguous collection, then the slices point directly into that collection.
+        // Otherwise, the elements are stored in a ring buffer, so only one new element is copied for each window.
+        // Using 0 as the window size will create an empty iterator.
+        detail::WindowsIter<ConcreteIterType> windows(size_t windowSize)
+        {
+            return detail::WindowsIter<ConcreteIterType>(*concrete_iter(), windowSize);
+        }
+
+        // Creates an iterator that yields the sum of each overlapping window of the given size (same windows as `windows`).
+        // The sum is updated by adding the new element and subtracting the oldest one, so each step takes O(1) time.
+        // For floating point types, the sum is recalculated from the stored elements after every windowSize steps,
+        // so rounding errors can't accumulate, and it's still O(1) amortized.
+        // Using 0 as the window size will create an empty iterator.
+        template <typename T = OutType>
+        detail::RollingSumIter<ConcreteIterType, T, false> rolling_sum(size_t windowSize)
+        {
+            return detail::RollingSumIter<ConcreteIterType, T, false>(*concrete_iter(), windowSize);
+        }
+
+        // Same as `rolling_sum`, but the sum of each window is divided by the window size, and the result is a double.
+        detail::RollingSumIter<ConcreteIterType, double, true> rolling_mean(size_t windowSize)
+        {
+            return detail::RollingSumIter<ConcreteIterType, double, true>(*concrete_iter(), windowSize);
+        }
+
+        // Creates an iterator that yields the minimum of each overlapping window of the given size (same windows as `windows`),
+        // comparing elements with the < and > operators.
+        // The candidates for the minimum are stored in a monotonic deque: when a new element arrives, the candidates which are
+        // not less than it are removed, because they can never be the minimum again. This way, each step takes amortized O(1) time,
+        // instead of O(windowSize) for `windows(n).map(...)`.
+        // Using 0 as the window size will create an empty iterator.
+        detail::RollingExtremeIter<ConcreteIterType, false> rolling_min(size_t windowSize)
+        {
+            return detail::RollingExtremeIter<ConcreteIterType, false>(*concrete_iter(), windowSize);
+        }
+
+        // Same as `rolling_min`, but yields the maximum of each window.
+        detail::RollingExtremeIter<ConcreteIterType, true> rolling_max(size_t windowSize)
+        {
+            return detail::RollingExtremeIter<ConcreteIterType, true>(*concrete_iter(), windowSize);
+        }
+
+        // Same as `chunks_exact`, but the chunk size is a compile time constant, and the chunks are yielded as `std::array` values.
+        // Because the size is known at compile time, loops over the chunks can be fully unrolled by the compiler.
+        // The elements at the end which don't fill a whole chunk are not yielded,
+        // they can be retrieved by calling `remainder` on the iterator after it has finished.
+        template <size_t N>
+        detail::ArrayChunksIter<ConcreteIterType, N> array_chunks()
+        {
+            return detail::ArrayChunksIter<ConcreteIterType, N>(*concrete_iter());
+        }
+
+        // Creates an iterator that groups consecutive elements which have the same key, and yields each group as a `rusty::Slice`.
+        // The key of each element is calculated by calling the provided key function, and the keys are compared with the == operator.
+        // Only consecutive elements are grouped, so if the iterator is sorted by the key, then each key will have exactly one group.
+        // If the current iterator was created from a contiguous collection, then the slices point directly into that collection.
+        // Otherwise, the elements of the current group are copied into a buffer, which is reused for every group.
+        template <typename KeyFunction>
+        detail::ChunkByIter<ConcreteIterType, KeyFunction> chunk_by(const KeyFunction& keyFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::check();
+
+            return detail::ChunkByIter<ConcreteIterType, KeyFunction>(*concrete_iter(), keyFunction);
+        }
+
+        // Creates an iterator that removes consecutive duplicate elements, comparing them with the == operator.
+        // Only the first element of each run of equal elements is yielded.
+        // If the current iterator is double-ended, then the new iterator is also double-ended.
+        detail::DedupIter<ConcreteIterType, detail::Identity, detail::Equality> dedup()
+        {
+            return detail::DedupIter<ConcreteIterType, detail::Identity, detail::Equality>(*concrete_iter(), detail::Identity(), detail::Equality());
+        }
+
+        // Same as `dedup`, but the elements are compared with the provided equality comparer function.
+        // The function takes two elements, and must return true if they are considered equal.
+        template <typename EqualityComparerFunction>
+        detail::DedupIter<ConcreteIterType, detail::Identity, EqualityComparerFunction> dedup_by(const EqualityComparerFunction& equalityComparerFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<EqualityComparerFunction, const OutType&, const OutType&>::check();
+
+            return detail::DedupIter<ConcreteIterType, detail::Identity, EqualityComparerFunction>(*concrete_iter(), detail::Identity(), equalityComparerFunction);
+        }
+
+        // Same as `dedup`, but the elements are considered equal if the provided key function returns equal keys for them.
+        // The key function is called once for each element, and the key of the last yielded element is stored.
+        template <typename KeyFunction>
+        detail::DedupIter<ConcreteIterType, KeyFunction, detail::Equality> dedup_by_key(const KeyFunction& keyFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::check();
+
+            return detail::DedupIter<ConcreteIterType, KeyFunction, detail::Equality>(*concrete_iter(), keyFunction, detail::Equality());
+        }
+
+        // Creates an iterator that only yields the first occurrence of each element, skipping elements that were already yielded.
+        // The elements are compared with the == operator, and they must be hashable with std::hash.
+        // The yielded elements are stored in a hash table, which is pre-sized if the length of the iterator is known.
+        detail::UniqueIter<ConcreteIterType, detail::Identity, false> unique()
+        {
+            return detail::UniqueIter<ConcreteIterType, detail::Identity, false>(*concrete_iter(), detail::Identity(), 0);
+        }
+
+        // Same as `unique`, but the elements are considered equal if the provided key function returns equal keys for them.
+        // The keys are compared with the == operator, and they must be hashable with std::hash.
+        template <typename KeyFunction>
+        detail::UniqueIter<ConcreteIterType, KeyFunction, false> unique_by(const KeyFunction& keyFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::check();
+
+            return detail::UniqueIter<ConcreteIterType, KeyFunction, false>(*concrete_iter(), keyFunction, 0);
+        }
+
+        // Same as `unique`, but at most about `capacity` elements are remembered, so the memory usage is constant.
+        // When there is no more space, then older elements are forgotten, so if they appear again, then they are yielded again.
+        // This means that an element is never skipped if it was not yielded before, but some duplicates may be yielded.
+        detail::UniqueIter<ConcreteIterType, detail::Identity, true> unique_bounded(size_t capacity)
+        {
+            return detail::UniqueIter<ConcreteIterType, detail::Identity, true>(*concrete_iter(), detail::Identity(), capacity);
+        }
+
+        // Same as `unique_by`, but at most about `capacity` keys are remembered, like in `unique_bounded`.
+        template <typename KeyFunction>
+        detail::UniqueIter<ConcreteIterType, KeyFunction, true> unique_by_bounded(const KeyFunction& keyFunction, size_t capacity)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::check();
+
+            return detail::UniqueIter<ConcreteIterType, KeyFunction, true>(*concrete_iter(), keyFunction, capacity);
+        }
+
+        //
+        // C++ iterator functionality
+        //
+
+        struct CppIterator
         {
             using value_type = OutType;
             using pointer = value_type*;
             using reference = value_type&;
 
-            CppIterator(Iterator* iter) : _iter(iter), _value()
+            CppIterator(Iterator* iter) : _iter(iter), _value()
+            {
+                step();
+            }
+
+            CppIterator() : _iter(nullptr), _value()
+            {
+            }
+
+            ~CppIterator()
+            {
+                _iter = nullptr;
+                _value.reset();
+            }
+
+            const OutType& operator*()
+            {
+                return *_value;
+            }
+
+            CppIterator& operator++()
+            {
+                step();
+                return *this;
+            }
+
+            CppIterator operator++(int)
+            {
+                CppIterator prev = *this;
+                step();
+                return prev;
+            }
+
+            const OutType* operator->() const
+            {
+                if (_value)
+                {
+                    return &*_value;
+                }
+                else
+                {
+                    return nullptr;
+                }
+            }
+
+            friend bool operator==(const CppIterator& a, const CppIterator& b)
+            {
+                return a._iter == b._iter && a.is_done() && b.is_done();
+            }
+
+            friend bool operator!=(const CppIterator& a, const CppIterator& b)
+            {
+                return !(a == b);
+            }
+
+        private:
+            void step()
+            {
+                if (!_iter)
+                {
+                    // the iterator has already finished
+                    return;
+                }
+
+                const OutType* first = _iter->next();
+                if (first)
+                {
+                    _value = *first;
+                }
+                else
+                {
+                    // no more elements left
+                    _iter = nullptr;
+                    _value.reset();
+                }
+            }
+
+            inline bool is_done() const
+            {
+                return !_value;
+            }
+
+            Iterator* _iter;
+            std::optional<OutType> _value;
+        };
+
+        CppIterator begin()
+        {
+            return CppIterator(this);
+        }
+
+        CppIterator end()
+        {
+            return CppIterator();
+        }
+
+    private:
+        inline ConcreteIterType* concrete_iter()
+        {
+            return static_cast<ConcreteIterType*>(this);
+        }
+
+        // Collects the remaining elements into a vector, reserving memory if the number of elements is known.
+        std::vector<OutType> collect_buffer()
+        {
+            std::vector<OutType> buffer;
+            if (std::optional<size_t> len = detail::known_len(*concrete_iter()))
+            {
+                buffer.reserve(*len);
+            }
+
+            while (const OutType* value = next())
+            {
+                buffer.push_back(*value);
+            }
+
+            return buffer;
+        }
+
+        // Shared implementation of `k_smallest_by_key` and `k_largest_by_key`.
+        // Same as `k_smallest_by`, but the heap contains (key, element) pairs, so the key function is only called once for each element.
+        template <bool Largest, typename KeyFunction>
+        std::vector<OutType> k_smallest_by_key_impl(size_t k, const KeyFunction& keyFunction)
+        {
+            using KeyType = std::decay_t<typename detail::ReturnTypeHelperConstRefOrValue<KeyFunction, const OutType&>::type>;
+            using Entry = std::pair<KeyType, OutType>;
+
+            std::vector<Entry> heap;
+            std::vector<OutType> result;
+            if (k == 0)
+            {
+                return result;
+            }
+
+            if (std::optional<size_t> len = detail::known_len(*concrete_iter()))
+            {
+                heap.reserve(*len < k ? *len : k);
+            }
+
+            auto less = [](const Entry& a, const Entry& b)
+            {
+                return (Largest ? detail::compare(b.first, a.first) : detail::compare(a.first, b.first)) < 0;
+            };
+
+            while (const OutType* value = next())
+            {
+                Entry entry(keyFunction(*value), *value);
+                if (heap.size() < k)
+                {
+                    heap.push_back(std::move(entry));
+                    std::push_heap(heap.begin(), heap.end(), less);
+                }
+                else if (less(entry, heap.front()))
+                {
+                    heap.front() = std::move(entry);
+                    detail::sift_down_root(heap.data(), heap.size(), less);
+                }
+            }
+
+            std::sort_heap(heap.begin(), heap.end(), less);
+            result.reserve(heap.size());
+            for (Entry& entry : heap)
+            {
+                result.push_back(std::move(entry.second));
+            }
+
+            return result;
+        }
+
+        // Shared implementation of `select_nth_by` and `median_by`: returns the element at index k of the sorted buffer.
+        template <typename Comparer>
+        static std::optional<OutType> select_nth_in_buffer(std::vector<OutType>& buffer, size_t k, const Comparer& comparer)
+        {
+            if (k >= buffer.size())
+            {
+                return { };
+            }
+
+            std::nth_element(buffer.begin(), buffer.begin() + k, buffer.end(), [&](const OutType& a, const OutType& b) { return comparer(a, b) < 0; });
+            return std::move(buffer[k]);
+        }
+
+        // Shared implementation of `partition_point` and `binary_search_by` for random access iterators:
+        // advances the iterator past the leading elements for which the predicate returns true with a binary search,
+        // and returns their number.
+        template <typename Predicate>
+        size_t partition_point_random_access(const Predicate& predicate)
+        {
+            if constexpr (detail::IsContiguousIter<ConcreteIterType>::value)
+            {
+                Slice<OutType> remaining = concrete_iter()->as_slice();
+                return concrete_iter()->advance_by(detail::partition_point_contiguous(remaining.data(), remaining.size(), predicate));
+            }
+            else
+            {
+                size_t low = 0;
+                size_t high = concrete_iter()->len();
+                while (low < high)
+                {
+                    size_t mid = low + (high - low) / 2;
+                    if (predicate(*concrete_iter()->get(mid)))
+                    {
+                        low = mid + 1;
+                    }
+                    else
+                    {
+                        high = mid;
+                    }
+                }
+
+                return concrete_iter()->advance_by(low);
+            }
+        }
+
+        // Shared implementation of `position_min_by` and `position_max_by`.
+        // The `isBetter` function returns true if its first parameter should replace the second one.
+        template <typename Position, typename IsBetterFunction>
+        std::optional<std::pair<Position, OutType>> position_extreme_by(const IsBetterFunction& isBetter)
+        {
+            const OutType* first = next();
+            if (!first)
+            {
+                return { };
+            }
+
+            detail::StoredValue<OutType, detail::HasStablePointers<ConcreteIterType>::value> best;
+            best.set(first);
+            Position bestPosition = Position(0);
+
+            Position pos = Position(1);
+            while (const OutType* value = next())
+            {
+                if (isBetter(*value, *best.get()))
+                {
+                    best.set(value);
+                    bestPosition = pos;
+                }
+
+                ++pos;
+            }
+
+            return std::make_pair(bestPosition, *best.get());
+        }
+
+        // Shared implementation of `position_min` and `position_max` for contiguous iterators of numbers.
+        template <bool FindMax, typename Position>
+        std::optional<std::pair<Position, OutType>> position_extreme_contiguous()
+        {
+            Slice<OutType> remaining = concrete_iter()->as_slice();
+            if (remaining.empty())
+            {
+                return { };
+            }
+
+            concrete_iter()->advance_by(remaining.size());
+
+            size_t index = detail::position_extreme_contiguous<FindMax>(remaining.data(), remaining.size());
+            return std::make_pair(static_cast<Position>(index), remaining[index]);
+        }
+    };
+
+    // Base class for double-ended (bidirectional) iterators.
+    template <typename ConcreteIterType, typename OutType>
+    struct DoubleEndedIterator : public Iterator<ConcreteIterType, OutType>
+    {
+        // Advances the back of the iterator, returning a value from its end.
+        // Returns nullptr if there are no more elements left, or the elements were already
+        // returned from the front of the iterator (so the end and the front of the iterator has already crossed).
+        const OutType* next_back()
+        {
+            return Iterator<ConcreteIterType, OutType>::concrete_iter()->next_back_impl();
+        }
+
+
+        //
+        // Consumer functions
+        //
+
+        // Returns the element at the given index from the back, by advancing the back of the iterator idx + 1 times.
+        // If the iterator doesn't have enough elements, then an empty value is returned.
+        template <typename T>
+        std::optional<OutType> nth_back(const T& idx)
+        {
+            T currentIdx = T(0);
+            while (const OutType* value = next_back())
+            {
+                if (currentIdx++ == idx)
+                {
+                    return *value;
+                }
+            }
+
+            return { };
+        }
+
+        // Same as `fold`, but starts the folding process from the back.
+        template <typename T, typename FoldFunction>
+        T rfold(T initialValue, const FoldFunction& foldFunction)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<FoldFunction, const T&, const OutType&>::check();
+
+            while (const OutType* value = next_back())
+            {
+                const T& currentValue = initialValue;
+                initialValue = foldFunction(currentValue, *value);
+            }
+
+            return initialValue;
+        }
+
+        // Same as `find`, but the search is started from the end.
+        template <typename Predicate>
+        std::optional<OutType> rfind(const Predicate& predicate)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            while (const OutType* value = next_back())
+            {
+                if (predicate(*value))
+                {
+                    return *value;
+                }
+            }
+
+            return { };
+        }
+
+        // Same as `position`, but the value is searched starting from the end.
+        template <typename Predicate, typename Position = size_t>
+        std::optional<Position> rposition(const Predicate& predicate)
+        {
+            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+
+            Position pos = Position(0);
+            while (const OutType* value = next_back())
+            {
+                if (predicate(*value))
+                {
+                    return pos;
+                }
+
+                ++pos;
+            }
+
+            return { };
+        }
+
+
+        //
+        // Iterator functions
+        //
+
+        // Reverses the iterator, causing `next` to return elements from the back,
+        // and `next_back` to return elements from the front.
+        detail::ReverseIter<ConcreteIterType> reverse()
+        {
+            return detail::ReverseIter<ConcreteIterType>(*Iterator<ConcreteIterType, OutType>::concrete_iter());
+        }
+    };
+
+    namespace detail
+    {
+        // Checks if a rusty iterator is a double-ended iterator.
+        template <typename IterType>
+        struct IsDoubleEndedIter : std::is_base_of<DoubleEndedIterator<IterType, typename IterType::OutType>, IterType>
+        {
+        };
+
+        // Base class for iterators which are double-ended only if the underlying iterator is double-ended.
+        template <typename ConcreteIterType, typename OutType, typename UnderlyingIterType>
+        using DoubleEndedIfUnderlying = std::conditional_t<IsDoubleEndedIter<UnderlyingIterType>::value,
+            DoubleEndedIterator<ConcreteIterType, OutType>,
+            Iterator<ConcreteIterType, OutType>>;
+    }
+
+    namespace detail
+    {
+        //
+        // Iterator implementations
+        //
+
+        template <typename CppIterType>
+        struct CppIteratorWrapper : public DoubleEndedIterator<CppIteratorWrapper<CppIterType>, typename ValueTypeHelper<CppIterType>::value_type>
+        {
+            using OutType = typename ValueTypeHelper<CppIterType>::value_type;
+
+            friend struct Iterator<CppIteratorWrapper<CppIterType>, OutType>;
+            friend struct DoubleEndedIterator<CppIteratorWrapper<CppIterType>, OutType>;
+
+            CppIteratorWrapper(const CppIterType& begin, const CppIterType& end) : _begin(begin), _end(end)
+            {
+            }
+
+            // Returns the number of remaining elements.
+            // Only available if the underlying C++ iterator is a random access iterator.
+            size_t len() const
+            {
+                return static_cast<size_t>(_end - _begin);
+            }
+
+            // Advances the iterator by the given number of elements (or less, if there are not enough elements left).
+            // Returns the number of elements the iterator was advanced by.
+            // Only available if the underlying C++ iterator is a random access iterator.
+            size_t advance_by(size_t count)
+            {
+                size_t remaining = len();
+                if (count > remaining)
+                {
+                    count = remaining;
+                }
+
+                _begin += count;
+                return count;
+            }
+
+            // Returns a pointer to the element at the given index, counted from the current position, without advancing the iterator.
+            // Returns null if there are not enough elements left.
+            // Only available if the underlying C++ iterator is a random access iterator.
+            const OutType* get(size_t index) const
+            {
+                if (index >= len())
+                {
+                    return nullptr;
+                }
+
+                return &*(_begin + index);
+            }
+
+            // Returns the remaining elements as a slice, without advancing the iterator.
+            // Only available if the underlying C++ iterator is contiguous (see `IsContiguousCppIterator`).
+            Slice<OutType> as_slice() const
+            {
+                static_assert(IsContiguousCppIterator<CppIterType>::value, "as_slice can only be used on contiguous iterators.");
+
+                if (_begin == _end)
+                {
+                    return Slice<OutType>();
+                }
+
+                return Slice<OutType>(&*_begin, len());
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_begin == _end)
+                {
+                    return nullptr;
+                }
+                else
+                {
+                    const OutType* current = &*_begin;
+                    ++_begin;
+                    return current;
+                }
+            }
+
+            const OutType* next_back_impl()
+            {
+                if (_begin == _end)
+                {
+                    return nullptr;
+                }
+                else
+                {
+                    // If you get a compiler error here, then it's likely that the C++ iterator is
+                    // a forward iterator, which does not support bi-directional iteration.
+                    return &*--_end;
+                }
+            }
+
+            CppIterType _begin;
+            CppIterType _end;
+        };
+
+        template <typename IterType, typename T>
+        struct StepByIter : public Iterator<StepByIter<IterType, T>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<StepByIter<IterType, T>, OutType>;
+
+            StepByIter(const IterType& iter, const T& stepSize) : _iter(iter), _stepSize(stepSize), _first(true), _invalid(stepSize <= 0)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_invalid)
+                {
+                    return nullptr;
+                }
+
+                if (_first)
+                {
+                    _first = false;
+                    return _iter.next();
+                }
+                else
+                {
+                    const OutType* last = nullptr;
+                    for (T i = 0; i < _stepSize; ++i)
+                    {
+                        last = _iter.next();
+                    }
+
+                    return last;
+                }
+            }
+
+            IterType _iter;
+            T _stepSize;
+            bool _first;
+            bool _invalid;
+        };
+
+        template <typename IterType, typename ChainedIterType>
+        struct ChainIter : public Iterator<ChainIter<IterType, ChainedIterType>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<ChainIter<IterType, ChainedIterType>, OutType>;
+
+            ChainIter(const IterType& iter, const ChainedIterType& chainedIter) : _iter(iter), _chainedIter(chainedIter), _firstDone(false)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (!_firstDone)
+                {
+                    const OutType* value = _iter.next();
+                    if (value != nullptr)
+                    {
+                        return value;
+                    }
+                    else
+                    {
+                        _firstDone = true;
+                    }
+                }
+
+                return _chainedIter.next();
+            }
+
+            IterType _iter;
+            ChainedIterType _chainedIter;
+            bool _firstDone;
+        };
+
+        template <typename IterType, typename ZippedIterType>
+        struct ZipIter : public Iterator<ZipIter<IterType, ZippedIterType>, std::pair<typename IterType::OutType, typename ZippedIterType::OutType>>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = std::pair<InType, typename ZippedIterType::OutType>;
+
+            friend struct Iterator<ZipIter<IterType, ZippedIterType>, OutType>;
+
+            ZipIter(const IterType& iter, const ZippedIterType& zippedIter) : _iter(iter), _zippedIter(zippedIter), _tmpResult(), _anyDone(false)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_anyDone)
+                {
+                    return nullptr;
+                }
+
+                const InType* value = _iter.next();
+                const typename ZippedIterType::OutType* zippedValue = _zippedIter.next();
+
+                if (value == nullptr || zippedValue == nullptr)
+                {
+                    // return null if any of the iterators are finished
+                    _anyDone = true;
+                    return nullptr;
+                }
+
+                _tmpResult = { *value, *zippedValue };
+                return &_tmpResult;
+            }
+
+            IterType _iter;
+            ZippedIterType _zippedIter;
+            OutType _tmpResult;
+            bool _anyDone;
+        };
+
+        template <typename IterType, typename SeparatorGetter>
+        struct IntersperseWithIter : public Iterator<IntersperseWithIter<IterType, SeparatorGetter>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<IntersperseWithIter<IterType, SeparatorGetter>, OutType>;
+
+            IntersperseWithIter(const IterType& iter, const SeparatorGetter& separatorGetter) :
+                _iter(iter), _separatorGetter(separatorGetter), _tmpResult(), _nextResult(), _separatorIsNext(false)
+            {
+                if (const OutType* next = _iter.next())
+                {
+                    // get the next result immediately, so that we can know if the iterator is empty or not
+                    _nextResult = *next;
+                }
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_separatorIsNext)
+                {
+                    _separatorIsNext = false;
+                    _tmpSeparator = _separatorGetter();
+                    return &*_tmpSeparator;
+                }
+                else
+                {
+                    if (_nextResult)
+                    {
+                        _tmpResult = *_nextResult;
+
+                        // check if we have a next element
+                        // if yes, then we need to insert a separator in the next call
+
+                        if (const OutType* next = _iter.next())
+                        {
+                            _nextResult = *next;
+                            _separatorIsNext = true;
+                        }
+                        else
+                        {
+                            _nextResult.reset();
+                        }
+
+                        return &*_tmpResult;
+                    }
+
+                    return nullptr;
+                }
+            }
+
+            IterType _iter;
+            SeparatorGetter _separatorGetter;
+            std::optional<OutType> _tmpSeparator;
+            std::optional<OutType> _tmpResult;
+            std::optional<OutType> _nextResult;
+            bool _separatorIsNext;
+        };
+
+        template <typename IterType, typename MapFunction>
+        struct MapIter : public Iterator<MapIter<IterType, MapFunction>, typename ReturnTypeHelperConstRefOrValue<MapFunction, typename IterType::OutType>::type>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = typename ReturnTypeHelperConstRefOrValue<MapFunction, InType>::type;
+
+            friend struct Iterator<MapIter<IterType, MapFunction>, OutType>;
+
+            MapIter(const IterType& iter, const MapFunction& mapFunction) : _iter(iter), _mapFunction(mapFunction), _tmpResult()
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (const InType* current = _iter.next())
+                {
+                    _tmpResult = _mapFunction(*current);
+                    return &*_tmpResult;
+                }
+                else
+                {
+                    return nullptr;
+                }
+            }
+
+            IterType _iter;
+            MapFunction _mapFunction;
+            std::optional<OutType> _tmpResult;
+        };
+
+        template <typename IterType, typename FilterFunction>
+        struct FilterIter : public Iterator<FilterIter<IterType, FilterFunction>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<FilterIter<IterType, FilterFunction>, OutType>;
+
+            FilterIter(const IterType& iter, const FilterFunction& filterFunction) : _iter(iter), _filterFunction(filterFunction)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                while (const InType* current = _iter.next())
+                {
+                    if (_filterFunction(*current))
+                    {
+                        return current;
+                    }
+                }
+
+                return nullptr;
+            }
+
+            IterType _iter;
+            FilterFunction _filterFunction;
+        };
+
+        // if you get a compile error here, then it's likely that your filterMapFunction doesn't return an std::optional value
+        template <typename IterType, typename FilterMapFunction>
+        struct FilterMapIter : public Iterator<FilterMapIter<IterType, FilterMapFunction>, typename ReturnTypeHelperConstRefOrValue<FilterMapFunction, typename IterType::OutType>::type::value_type>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = typename ReturnTypeHelperConstRefOrValue<FilterMapFunction, InType>::type::value_type;
+
+            friend struct Iterator<FilterMapIter<IterType, FilterMapFunction>, OutType>;
+
+            FilterMapIter(const IterType& iter, const FilterMapFunction& filterMapFunction) : _iter(iter), _filterMapFunction(filterMapFunction), _tmpResult()
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                while (const InType* current = _iter.next())
+                {
+                    std::optional<OutType> result = _filterMapFunction(*current);
+                    if (result)
+                    {
+                        _tmpResult = *result;
+                        return &_tmpResult;
+                    }
+                }
+
+                return nullptr;
+            }
+
+            IterType _iter;
+            FilterMapFunction _filterMapFunction;
+            OutType _tmpResult;
+        };
+
+        template <typename IterType>
+        struct PeekableIter : public Iterator<PeekableIter<IterType>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<PeekableIter<IterType>, OutType>;
+
+            PeekableIter(const IterType& iter) : _iter(iter), _nextItem(), _tmpResult()
+            {
+            }
+
+            // Returns the next item, without advancing the iterator.
+            // Returns null if there are no more elements.
+            const OutType* peek()
+            {
+                if (!_nextItem)
+                {
+                    // next item is unknown, get it from the iter
+                    if (const OutType* next = _iter.next())
+                    {
+                        // iter still has values
+                        _nextItem.emplace(*next);
+                    }
+                    else
+                    {
+                        // iter has finished, no more values
+                        _nextItem.reset();
+                        return nullptr;
+                    }
+                }
+
+                std::optional<OutType>& nextValue = *_nextItem;
+                if (nextValue)
+                {
+                    // next item is known, and has value
+                    return &*nextValue;
+                }
+                else
+                {
+                    // next item is known, but has no value
+                    return nullptr;
+                }
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_nextItem)
+                {
+                    // next item was already peeked
+
+                    _tmpResult = *_nextItem;
+                    _nextItem.reset();
+
+                    if (_tmpResult)
+                    {
+                        return &*_tmpResult;
+                    }
+                    else
+                    {
+                        return nullptr;
+                    }
+                }
+
+                // next item was not peeked, just return the next item from the iter
+                return _iter.next();
+            }
+
+            IterType _iter;
+            std::optional<std::optional<OutType>> _nextItem;
+            std::optional<OutType> _tmpResult;
+        };
+
+        template <typename IterType, typename Predicate>
+        struct SkipWhileIter : public Iterator<SkipWhileIter<IterType, Predicate>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<SkipWhileIter<IterType, Predicate>, OutType>;
+
+            SkipWhileIter(const IterType& iter, const Predicate& predicate) : _iter(iter), _predicate(predicate), _done(false)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (!_done)
+                {
+                    _done = true;
+
+                    while (const OutType* value = _iter.next())
+                    {
+                        if (!_predicate(*value))
+                        {
+                            return value;
+                        }
+                    }
+
+                    return nullptr;
+                }
+
+                return _iter.next();
+            }
+
+            IterType _iter;
+            Predicate _predicate;
+            bool _done;
+        };
+
+        template <typename IterType, typename Predicate>
+        struct TakeWhileIter : public Iterator<TakeWhileIter<IterType, Predicate>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<TakeWhileIter<IterType, Predicate>, OutType>;
+
+            TakeWhileIter(const IterType& iter, const Predicate& predicate) : _iter(iter), _predicate(predicate), _done(false)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_done)
+                {
+                    return nullptr;
+                }
+
+                if (const OutType* value = _iter.next())
+                {
+                    if (_predicate(*value))
+                    {
+                        return value;
+                    }
+                }
+
+                _done = true;
+                return nullptr;
+            }
+
+            IterType _iter;
+            Predicate _predicate;
+            bool _done;
+        };
+
+        // if you get a compile error here, then it's likely that your mapWhileFunction doesn't return an std::optional value
+        template <typename IterType, typename MapWhileFunction>
+        struct MapWhileIter : public Iterator<MapWhileIter<IterType, MapWhileFunction>, typename ReturnTypeHelperConstRefOrValue<MapWhileFunction, typename IterType::OutType>::type::value_type>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = typename ReturnTypeHelperConstRefOrValue<MapWhileFunction, InType>::type::value_type;
+
+            friend struct Iterator<MapWhileIter<IterType, MapWhileFunction>, OutType>;
+
+            MapWhileIter(const IterType& iter, const MapWhileFunction& mapWhileFunction) : _iter(iter), _mapWhileFunction(mapWhileFunction), _tmpResult(), _done(false)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_done)
+                {
+                    return nullptr;
+                }
+
+                if (const InType* value = _iter.next())
+                {
+                    _tmpResult = _mapWhileFunction(*value);
+                    if (_tmpResult)
+                    {
+                        return &*_tmpResult;
+                    }
+                }
+
+                _done = true;
+                return nullptr;
+            }
+
+            IterType _iter;
+            MapWhileFunction _mapWhileFunction;
+            std::optional<OutType> _tmpResult;
+            bool _done;
+        };
+
+        template <typename IterType>
+        struct FlattenIter : Iterator<FlattenIter<IterType>, typename IterType::OutType::OutType>
+        {
+            using InnerIterType = typename IterType::OutType;
+            using InType = IterType;
+            using OutType = typename InnerIterType::OutType;
+
+            friend struct Iterator<FlattenIter<IterType>, OutType>;
+
+            FlattenIter(const IterType& iter) : _iter(iter), _innerIter()
+            {
+                advance();
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (!_innerIter)
+                {
+                    return nullptr;
+                }
+
+                while (true)
+                {
+                    if (const OutType* value = _innerIter->next())
+                    {
+                        return value;
+                    }
+                    else
+                    {
+                        if (!advance())
+                        {
+                            return nullptr;
+                        }
+                    }
+                }
+            }
+
+            bool advance()
+            {
+                if (const InnerIterType* inner = _iter.next())
+                {
+                    _innerIter = *inner;
+                    return true;
+                }
+                else
+                {
+                    _innerIter.reset();
+                    return false;
+                }
+            }
+
+            IterType _iter;
+            std::optional<InnerIterType> _innerIter;
+        };
+
+        template <typename IterType, typename InspectCallback>
+        struct InspectIter : public Iterator<InspectIter<IterType, InspectCallback>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<InspectIter<IterType, InspectCallback>, OutType>;
+
+            InspectIter(const IterType& iter, const InspectCallback& inspectCallback) : _iter(iter), _inspectCallback(inspectCallback)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                const OutType* value = _iter.next();
+                if (value)
+                {
+                    _inspectCallback(*value);
+                }
+
+                return value;
+            }
+
+            IterType _iter;
+            InspectCallback _inspectCallback;
+        };
+
+        template <typename IterType>
+        struct CycleIter : public Iterator<CycleIter<IterType>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<CycleIter<IterType>, OutType>;
+
+            CycleIter(const IterType& iter) : _originalIter(iter), _iter(iter), _iterIsEmpty(true)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (const OutType* value = _iter.next())
+                {
+                    _iterIsEmpty = false;
+                    return value;
+                }
+
+                if (_iterIsEmpty)
+                {
+                    return nullptr;
+                }
+
+                // lambdas don't have a copy assignment operator, so if there is a lambda in the iterator chain,
+                // then this will cause a compiler error:
+                // _iter = _originalIter;
+                // instead, we have to use the copy constructor, which works just fine (also call the destructor before)
+                _iter.~IterType();
+                new (&_iter) IterType(_originalIter);
+
+                return _iter.next();
+            }
+
+            IterType _originalIter;
+            IterType _iter;
+            bool _iterIsEmpty;
+        };
+
+        template <typename IterType, bool Exact>
+        struct ChunksIter : public Iterator<ChunksIter<IterType, Exact>, Slice<typename IterType::OutType>>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = Slice<InType>;
+
+            friend struct Iterator<ChunksIter<IterType, Exact>, OutType>;
+
+            ChunksIter(const IterType& iter, size_t chunkSize) : _iter(iter), _chunkSize(chunkSize), _buffer(), _tmpResult(), _done(chunkSize == 0)
+            {
+            }
+
+            // Returns the elements at the end of the iterator, which did not fill a whole chunk.
+            // The remainder is only known after the iterator has finished, before that an empty slice is returned.
+            // The returned slice becomes invalid if the iterator goes out of scope.
+            Slice<InType> remainder() const
+            {
+                static_assert(Exact, "remainder can only be used with chunks_exact.");
+
+                if (!_done)
+                {
+                    return Slice<InType>();
+                }
+
+                if constexpr (IsContiguousIter<IterType>::value)
+                {
+                    // the remaining elements are not consumed from a contiguous iterator
+                    return _iter.as_slice();
+                }
+                else
+                {
+                    return Slice<InType>(_buffer.data(), _buffer.size());
+                }
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_done)
+                {
+                    return nullptr;
+                }
+
+                if constexpr (IsContiguousIter<IterType>::value)
+                {
+                    // no need to copy anything, just point into the original collection
+                    Slice<InType> remaining = _iter.as_slice();
+                    size_t size = remaining.size() < _chunkSize ? remaining.size() : _chunkSize;
+
+                    if (size == 0 || (Exact && size < _chunkSize))
+                    {
+                        _done = true;
+                        return nullptr;
+                    }
+
+                    _iter.advance_by(size);
+                    _tmpResult = Slice<InType>(remaining.data(), size);
+                    return &_tmpResult;
+                }
+                else
+                {
+                    if (_buffer.capacity() < _chunkSize)
+                    {
+                        _buffer.reserve(_chunkSize);
+                    }
+
+                    _buffer.clear();
+                    while (_buffer.size() < _chunkSize)
+                    {
+                        if (const InType* value = _iter.next())
+                        {
+                            _buffer.push_back(*value);
+                        }
+                        else
+                        {
+                            _done = true;
+                            break;
+                        }
+                    }
+
+                    if (_buffer.empty() || (Exact && _buffer.size() < _chunkSize))
+                    {
+                        // for chunks_exact, the buffer now contains the remainder
+                        _done = true;
+                        return nullptr;
+                    }
+
+                    _tmpResult = Slice<InType>(_buffer.data(), _buffer.size());
+                    return &_tmpResult;
+                }
+            }
+
+            IterType _iter;
+            size_t _chunkSize;
+            std::vector<InType> _buffer;
+            OutType _tmpResult;
+            bool _done;
+        };
+
+        template <typename IterType>
+        struct WindowsIter : public Iterator<WindowsIter<IterType>, Slice<typename IterType::OutType>>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = Slice<InType>;
+
+            friend struct Iterator<WindowsIter<IterType>, OutType>;
+
+            WindowsIter(const IterType& iter, size_t windowSize) : _iter(iter), _windowSize(windowSize), _buffer(), _head(0), _tmpResult(), _done(windowSize == 0)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_done)
+                {
+                    return nullptr;
+                }
+
+                if constexpr (IsContiguousIter<IterType>::value)
+                {
+                    // no need to copy anything, just point into the original collection
+                    Slice<InType> remaining = _iter.as_slice();
+                    if (remaining.size() < _windowSize)
+                    {
+                        _done = true;
+                        return nullptr;
+                    }
+
+                    _iter.advance_by(1);
+                    _tmpResult = Slice<InType>(remaining.data(), _windowSize);
+                    return &_tmpResult;
+                }
+                else
+                {
+                    // the buffer contains every element twice, at index i and i + windowSize,
+                    // so the current window is always contiguous, starting at _head
+                    if (_buffer.empty())
+                    {
+                        _buffer.reserve(_windowSize * 2);
+                        while (_buffer.size() < _windowSize)
+                        {
+                            if (const InType* value = _iter.next())
+                            {
+                                _buffer.push_back(*value);
+                            }
+                            else
+                            {
+                                _done = true;
+                                return nullptr;
+                            }
+                        }
+
+                        for (size_t i = 0; i < _windowSize; ++i)
+                        {
+                            _buffer.push_back(_buffer[i]);
+                        }
+                    }
+                    else
+                    {
+                        const InType* value = _iter.next();
+                        if (!value)
+                        {
+                            _done = true;
+                            return nullptr;
+                        }
+
+                        // overwrite the oldest element
+                        _buffer[_head] = *value;
+                        _buffer[_head + _windowSize] = *value;
+
+                        if (++_head == _windowSize)
+                        {
+                            _head = 0;
+                        }
+                    }
+
+                    _tmpResult = Slice<InType>(_buffer.data() + _head, _windowSize);
+                    return &_tmpResult;
+                }
+            }
+
+            IterType _iter;
+            size_t _windowSize;
+            std::vector<InType> _buffer;
+            size_t _head;
+            OutType _tmpResult;
+            bool _done;
+        };
+
+        template <typename IterType, typename SumType, bool Mean>
+        struct RollingSumIter : public Iterator<RollingSumIter<IterType, SumType, Mean>, SumType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = SumType;
+
+            friend struct Iterator<RollingSumIter<IterType, SumType, Mean>, OutType>;
+
+            RollingSumIter(const IterType& iter, size_t windowSize) :
+                _iter(iter), _windowSize(windowSize), _buffer(), _head(0), _sum(SumType(0)), _tmpResult(), _done(windowSize == 0)
+            {
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_done)
+                {
+                    return nullptr;
+                }
+
+                if (_buffer.empty())
+                {
+                    _buffer.reserve(_windowSize);
+                    while (_buffer.size() < _windowSize)
+                    {
+                        const InType* value = _iter.next();
+                        if (!value)
+                        {
+                            _done = true;
+                            return nullptr;
+                        }
+
+                        _buffer.push_back(*value);
+                        _sum += _buffer.back();
+                    }
+                }
+                else
+                {
+                    const InType* value = _iter.next();
+                    if (!value)
+                    {
+                        _done = true;
+                        return nullptr;
+                    }
+
+                    // replace the oldest element
+                    _sum -= _buffer[_head];
+                    _buffer[_head] = *value;
+                    _sum += _buffer[_head];
+
+                    if (++_head == _windowSize)
+                    {
+                        _head = 0;
+                        if constexpr (std::is_floating_point_v<SumType>)
+                        {
+                            recalculate_sum();
+                        }
+                    }
+                }
+
+                if constexpr (Mean)
+                {
+                    _tmpResult = _sum / static_cast<SumType>(_windowSize);
+                }
+                else
+                {
+                    _tmpResult = _sum;
+                }
+
+                return &_tmpResult;
+            }
+
+            void recalculate_sum()
             {
-                step();
+                _sum = SumType(0);
+                for (const InType& value : _buffer)
+                {
+                    _sum += value;
+                }
             }
 
-            CppIterator() : _iter(nullptr), _value()
+            IterType _iter;
+            size_t _windowSize;
+            std::vector<InType> _buffer;
+            size_t _head;
+            SumType _sum;
+            OutType _tmpResult;
+            bool _done;
+        };
+
+        template <typename IterType, bool Max>
+        struct RollingExtremeIter : public Iterator<RollingExtremeIter<IterType, Max>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<RollingExtremeIter<IterType, Max>, OutType>;
+
+            RollingExtremeIter(const IterType& iter, size_t windowSize) :
+                _iter(iter), _windowSize(windowSize), _deque(), _front(0), _size(0), _index(0), _done(windowSize == 0)
             {
             }
 
-            ~CppIterator()
+        private:
+            // The deque contains (index, value) pairs, with strictly increasing indices, and values in increasing order
+            // (decreasing for Max), so the front is always the extreme of the current window.
+            // It never contains more than windowSize elements, so it's stored in a ring buffer of that size.
+
+            const OutType* next_impl()
             {
-                _iter = nullptr;
-                _value.reset();
+                if (_done)
+                {
+                    return nullptr;
+                }
+
+                if (_deque.empty())
+                {
+                    _deque.reserve(_windowSize);
+                }
+
+                do
+                {
+                    const InType* value = _iter.next();
+                    if (!value)
+                    {
+                        _done = true;
+                        return nullptr;
+                    }
+
+                    // remove the elements from the back which can't be the extreme anymore
+                    while (_size != 0 && !is_better(_deque[wrap(_front + _size - 1)].second, *value))
+                    {
+                        --_size;
+                    }
+
+                    // remove the element from the front which is no longer in the window
+                    if (_size != 0 && _deque[_front].first + _windowSize <= _index)
+                    {
+                        _front = wrap(_front + 1);
+                        --_size;
+                    }
+
+                    // the slots of the ring buffer are used in order at first, so a new slot is always the next one
+                    size_t slot = wrap(_front + _size);
+                    if (slot == _deque.size())
+                    {
+                        _deque.emplace_back(_index, *value);
+                    }
+                    else
+                    {
+                        _deque[slot] = std::make_pair(_index, *value);
+                    }
+
+                    ++_size;
+                    ++_index;
+                } while (_index < _windowSize);
+
+                return &_deque[_front].second;
             }
 
-            const OutType& operator*()
+            static bool is_better(const InType& a, const InType& b)
             {
-                return *_value;
+                if constexpr (Max)
+                {
+                    return compare(a, b) > 0;
+                }
+                else
+                {
+                    return compare(a, b) < 0;
+                }
             }
 
-            CppIterator& operator++()
+            size_t wrap(size_t index) const
             {
-                step();
-                return *this;
+                return index >= _windowSize ? index - _windowSize : index;
             }
 
-            CppIterator operator++(int)
+            IterType _iter;
+            size_t _windowSize;
+            std::vector<std::pair<size_t, InType>> _deque;
+            size_t _front;
+            size_t _size;
+            size_t _index;
+            bool _done;
+        };
+
+        template <typename IterType, size_t N>
+        struct ArrayChunksIter : public Iterator<ArrayChunksIter<IterType, N>, std::array<typename IterType::OutType, N>>
+        {
+            static_assert(N > 0, "The chunk size must be greater than 0.");
+
+            using InType = typename IterType::OutType;
+            using OutType = std::array<InType, N>;
+
+            friend struct Iterator<ArrayChunksIter<IterType, N>, OutType>;
+
+            ArrayChunksIter(const IterType& iter) : _iter(iter), _tmpResult(), _remainderSize(0), _done(false)
             {
-                CppIterator prev = *this;
-                step();
-                return prev;
             }
 
-            const OutType* operator->() const
+            // Returns the elements at the end of the iterator, which did not fill a whole chunk.
+            // The remainder is only known after the iterator has finished, before that an empty slice is returned.
+            // The returned slice becomes invalid if the iterator goes out of scope.
+            Slice<InType> remainder() const
             {
-                if (_value)
+                if (!_done)
                 {
-                    return &*_value;
+                    return Slice<InType>();
+                }
+
+                if constexpr (IsContiguousIter<IterType>::value)
+                {
+                    // the remaining elements are not consumed from a contiguous iterator
+                    return _iter.as_slice();
                 }
                 else
+                {
+                    return Slice<InType>(_tmpResult.data(), _remainderSize);
+                }
+            }
+
+        private:
+            const OutType* next_impl()
+            {
+                if (_done)
                 {
                     return nullptr;
                 }
+
+                if constexpr (IsContiguousIter<IterType>::value)
+                {
+                    Slice<InType> remaining = _iter.as_slice();
+                    if (remaining.size() < N)
+                    {
+                        _done = true;
+                        return nullptr;
+                    }
+
+                    const InType* data = remaining.data();
+                    for (size_t i = 0; i < N; ++i)
+                    {
+                        _tmpResult[i] = data[i];
+                    }
+
+                    _iter.advance_by(N);
+                    return &_tmpResult;
+                }
+                else
+                {
+                    for (size_t i = 0; i < N; ++i)
+                    {
+                        if (const InType* value = _iter.next())
+                        {
+                            _tmpResult[i] = *value;
+                        }
+                        else
+                        {
+                            // the first i elements of the array are the remainder
+                            _remainderSize = i;
+                            _done = true;
+                            return nullptr;
+                        }
+                    }
+
+                    return &_tmpResult;
+                }
             }
 
-            friend bool operator==(const CppIterator& a, const CppIterator& b)
+            IterType _iter;
+            OutType _tmpResult;
+            size_t _remainderSize;
+            bool _done;
+        };
+
+        template <typename IterType, typename KeyFunction>
+        struct ChunkByIter : public Iterator<ChunkByIter<IterType, KeyFunction>, Slice<typename IterType::OutType>>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = Slice<InType>;
+            using KeyType = std::decay_t<typename ReturnTypeHelperConstRefOrValue<KeyFunction, InType>::type>;
+
+            friend struct Iterator<ChunkByIter<IterType, KeyFunction>, OutType>;
+
+            ChunkByIter(const IterType& iter, const KeyFunction& keyFunction) :
+                _iter(iter), _keyFunction(keyFunction), _buffer(), _nextValue(), _nextKey(), _tmpResult()
             {
-                return a._iter == b._iter && a.is_done() && b.is_done();
             }
 
-            friend bool operator!=(const CppIterator& a, const CppIterator& b)
+        private:
+            const OutType* next_impl()
+            {
+                if constexpr (IsContiguousIter<IterType>::value)
+                {
+                    // no need to copy anything, just point into the original collection
+                    Slice<InType> remaining = _iter.as_slice();
+                    if (remaining.empty())
+                    {
+                        return nullptr;
+                    }
+
+                    // the key of the first element may already be known from the previous group
+                    KeyType key = _nextKey ? std::move(*_nextKey) : _keyFunction(remaining[0]);
+                    _nextKey.reset();
+
+                    size_t size = 1;
+                    while (size < remaining.size())
+                    {
+                        KeyType currentKey = _keyFunction(remaining[size]);
+                        if (!(currentKey == key))
+                        {
+                            _nextKey.emplace(std::move(currentKey));
+                            break;
+                        }
+
+                        ++size;
+                    }
+
+                    _iter.advance_by(size);
+                    _tmpResult = Slice<InType>(remaining.data(), size);
+                    return &_tmpResult;
+                }
+                else
+                {
+                    // the first element of the group was already retrieved when the end of the previous group was found
+                    if (!_nextValue)
+                    {
+                        if (const InType* first = _iter.next())
+                        {
+                            _nextValue.emplace(*first);
+                            _nextKey.emplace(_keyFunction(*first));
+                        }
+                        else
+                        {
+                            return nullptr;
+                        }
+                    }
+
+                    _buffer.clear();
+                    _buffer.push_back(std::move(*_nextValue));
+                    _nextValue.reset();
+
+                    KeyType key = std::move(*_nextKey);
+                    _nextKey.reset();
+
+                    while (const InType* value = _iter.next())
+                    {
+                        KeyType currentKey = _keyFunction(*value);
+                        if (!(currentKey == key))
+                        {
+                            _nextValue.emplace(*value);
+                            _nextKey.emplace(std::move(currentKey));
+                            break;
+                        }
+
+                        _buffer.push_back(*value);
+                    }
+
+                    _tmpResult = Slice<InType>(_buffer.data(), _buffer.size());
+                    return &_tmpResult;
+                }
+            }
+
+            IterType _iter;
+            KeyFunction _keyFunction;
+            std::vector<InType> _buffer;
+            std::optional<InType> _nextValue;
+            std::optional<KeyType> _nextKey;
+            OutType _tmpResult;
+        };
+
+        template <typename IterType, typename KeyFunction, typename EqualityFunction>
+        struct DedupIter : public DoubleEndedIfUnderlying<DedupIter<IterType, KeyFunction, EqualityFunction>, typename IterType::OutType, IterType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+
+            friend struct Iterator<DedupIter<IterType, KeyFunction, EqualityFunction>, OutType>;
+            friend struct DoubleEndedIterator<DedupIter<IterType, KeyFunction, EqualityFunction>, OutType>;
+
+            DedupIter(const IterType& iter, const KeyFunction& keyFunction, const EqualityFunction& equalityFunction) :
+                _iter(iter), _keyFunction(keyFunction), _equalityFunction(equalityFunction),
+                _last(), _lastKey(), _back(), _backKey(), _backNext(), _backNextKey()
             {
-                return !(a == b);
             }
 
         private:
-            void step()
+            using Stored = StoredValue<InType, HasStablePointers<IterType>::value>;
+            using Key = StoredKey<InType, KeyFunction>;
+
+            // The sequence of the remaining elements is: the remaining elements of _iter, then _backNext (if set).
+            // _last is the last element yielded from the front, _back is the last element yielded from the back.
+            // Each of them is stored together with its key.
+
+            const OutType* next_impl()
             {
-                if (!_iter)
+                while (true)
                 {
-                    // the iterator has already finished
-                    return;
+                    const InType* value = _iter.next();
+                    Key key;
+                    bool isBackNext = false;
+                    if (value)
+                    {
+                        key.set(_keyFunction, *value);
+                    }
+                    else
+                    {
+                        // the underlying iterator has finished, but there might be one more element which was read from the back
+                        value = _backNext.get();
+                        if (!value)
+                        {
+                            return nullptr;
+                        }
+
+                        key = _backNextKey;
+                        isBackNext = true;
+                    }
+
+                    const InType* last = _last.get();
+                    bool isDuplicate = last && _equalityFunction(_lastKey.get(*last), key.get(*value));
+
+                    if (isBackNext)
+                    {
+                        if (isDuplicate)
+                        {
+                            _backNext.reset();
+                            return nullptr;
+                        }
+
+                        _last.set(value);
+                        _lastKey = key;
+                        _backNext.reset();
+                        return _last.get();
+                    }
+
+                    if (!isDuplicate)
+                    {
+                        _last.set(value);
+                        _lastKey = std::move(key);
+                        return value;
+                    }
                 }
+            }
 
-                const OutType* first = _iter->next();
-                if (first)
+            const OutType* next_back_impl()
+            {
+                // when iterating from the back, the whole run of equal elements needs to be read,
+                // so that the first element of the run can be yielded (same as when iterating from the front)
+                if (const InType* backNext = _backNext.get())
+                {
+                    _back.set(backNext);
+                    _backKey = _backNextKey;
+                    _backNext.reset();
+                }
+                else if (const InType* value = _iter.next_back())
+                {
+                    _back.set(value);
+                    _backKey.set(_keyFunction, *value);
+                }
+                else
+                {
+                    return nullptr;
+                }
+
+                while (const InType* value = _iter.next_back())
+                {
+                    Key key;
+                    key.set(_keyFunction, *value);
+                    if (!_equalityFunction(key.get(*value), _backKey.get(*_back.get())))
+                    {
+                        // this element starts a different run, it will be processed later
+                        _backNext.set(value);
+                        _backNextKey = std::move(key);
+                        return _back.get();
+                    }
+
+                    _back.set(value);
+                    _backKey = std::move(key);
+                }
+
+                // the underlying iterator has finished, so this run continues at the front
+                // if it's the same as the last element yielded from the front, then it was already yielded
+                const InType* last = _last.get();
+                if (last && _equalityFunction(_lastKey.get(*last), _backKey.get(*_back.get())))
+                {
+                    return nullptr;
+                }
+
+                return _back.get();
+            }
+
+            IterType _iter;
+            KeyFunction _keyFunction;
+            EqualityFunction _equalityFunction;
+            Stored _last;
+            Key _lastKey;
+            Stored _back;
+            Key _backKey;
+            Stored _backNext;
+            Key _backNextKey;
+        };
+
+        template <typename IterType, typename KeyFunction, bool Bounded>
+        struct UniqueIter : public Iterator<UniqueIter<IterType, KeyFunction, Bounded>, typename IterType::OutType>
+        {
+            using InType = typename IterType::OutType;
+            using OutType = InType;
+            using KeyType = std::decay_t<typename ReturnTypeHelperConstRefOrValue<KeyFunction, InType>::type>;
+
+            friend struct Iterator<UniqueIter<IterType, KeyFunction, Bounded>, OutType>;
+
+            UniqueIter(const IterType& iter, const KeyFunction& keyFunction, size_t capacity) : _iter(iter), _keyFunction(keyFunction), _seen()
+            {
+                if constexpr (Bounded)
                 {
-                    _value = *first;
+                    _seen.reserve(capacity);
                 }
-                else
+                else if (std::optional<size_t> len = known_len(_iter))
                 {
-                    // no more elements left
-                    _iter = nullptr;
-                    _value.reset();
+                    _seen.reserve(*len);
                 }
             }
 
-            inline bool is_done() const
+        private:
+            // number of slots checked when inserting into a bounded table, before replacing an older key
+            static constexpr size_t MaxBoundedProbes = 8;
+
+            const OutType* next_impl()
             {
-                return !_value;
+                while (const InType* value = _iter.next())
+                {
+                    bool inserted;
+                    if constexpr (Bounded)
+                    {
+                        inserted = _seen.insert_bounded(_keyFunction(*value), Empty(), MaxBoundedProbes).second;
+                    }
+                    else
+                    {
+                        inserted = _seen.insert(_keyFunction(*value), Empty()).second;
+                    }
+
+                    if (inserted)
+                    {
+                        return value;
+                    }
+                }
+
+                return nullptr;
             }
 
-            Iterator* _iter;
-            std::optional<OutType> _value;
+            IterType _iter;
+            KeyFunction _keyFunction;
+            HashTable<KeyType, Empty> _seen;
         };
 
-        CppIterator begin()
-        {
-            return CppIterator(this);
-        }
-
-        CppIterator end()
+        template <typename IterType>
+        struct FuseIter : public DoubleEndedIfUnderlying<FuseIter<IterType>, typename IterType::OutType, IterType>
         {
-            return CppIterator();
-        }
+            using InType = typename IterType::OutType;
+            using OutType = InType;
 
-    private:
-        inline ConcreteIterType* concrete_iter()
-        {
-            return static_cast<ConcreteIterType*>(this);
-        }
-    };
+            friend struct Iterator<FuseIter<IterType>, OutType>;
+            friend struct DoubleEndedIterator<FuseIter<IterType>, OutType>;
 
-    // Base class for double-ended (bidirectional) iterators.
-    template <typename ConcreteIterType, typename OutType>
-    struct DoubleEndedIterator : public Iterator<ConcreteIterType, OutType>
-    {
-        // Advances the back of the iterator, returning a value from its end.
-        // Returns nullptr if there are no more elements left, or the elements were already
-        // returned from the front of the iterator (so the end and the front of the iterator has already crossed).
-        const OutType* next_back()
-        {
-            return Iterator<ConcreteIterType, OutType>::concrete_iter()->next_back_impl();
-        }
+            FuseIter(const IterType& iter) : _iter(iter), _done(false)
+            {
+            }
 
+        private:
+            const OutType* next_impl()
+            {
+                if (_done)
+                {
+                    return nullptr;
+                }
 
-        //
-        // Consumer functions
-        //
+                const OutType* value = _iter.next();
+                _done = !value;
+                return value;
+            }
 
-        // Returns the element at the given index from the back, by advancing the back of the iterator idx + 1 times.
-        // If the iterator doesn't have enough elements, then an empty value is returned.
-        template <typename T>
-        std::optional<OutType> nth_back(const T& idx)
-        {
-            T currentIdx = T(0);
-            while (const OutType* value = next_back())
+            const OutType* next_back_impl()
             {
-                if (currentIdx++ == idx)
+                if (_done)
                 {
-                    return *value;
+                    return nullptr;
                 }
+
+                const OutType* value = _iter.next_back();
+                _done = !value;
+                return value;
             }
 
-            return { };
-        }
+            IterType _iter;
+            bool _done;
+        };
 
-        // Same as `fold`, but starts the folding process from the back.
-        template <typename T, typename FoldFunction>
-        T rfold(T initialValue, const FoldFunction& foldFunction)
+        template <typename IterType, typename OtherIterType, typename Comparer>
+        struct MergeIter : public Iterator<MergeIter<IterType, OtherIterType, Comparer>, typename IterType::OutType>
         {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<FoldFunction, const T&, const OutType&>::check();
+            using InType = typename IterType::OutType;
+            using OutType = InType;
 
-            while (const OutType* value = next_back())
-            {
-                const T& currentValue = initialValue;
-                initialValue = foldFunction(currentValue, *value);
-            }
+            static_assert(std::is_same_v<InType, typename OtherIterType::OutType>, "Only iterators with the same element type can be merged.");
 
-            return initialValue;
-        }
+            friend struct Iterator<MergeIter<IterType, OtherIterType, Comparer>, OutType>;
 
-        // Same as `find`, but the search is started from the end.
-        template <typename Predicate>
-        std::optional<OutType> rfind(const Predicate& predicate)
-        {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+            MergeIter(const IterType& iter, const OtherIterType& otherIter, const Comparer& comparer) :
+                _iter(iter), _otherIter(otherIter), _comparer(comparer), _head(), _otherHead(), _advance(true), _advanceOther(true)
+            {
+            }
 
-            while (const OutType* value = next_back())
+        private:
+            const OutType* next_impl()
             {
-                if (predicate(*value))
+                // the current values of both iterators are stored, and an iterator is only advanced when its previous value was already yielded
+                // (only pointers are stored if the iterator has stable pointers, otherwise the values are copied,
+                // so the pointers don't point into the other iterators if this iterator is copied)
+                if (_advance)
                 {
-                    return *value;
+                    _head.assign(_iter.next());
+                    _advance = false;
                 }
-            }
 
-            return { };
-        }
+                if (_advanceOther)
+                {
+                    _otherHead.assign(_otherIter.next());
+                    _advanceOther = false;
+                }
 
-        // Same as `position`, but the value is searched starting from the end.
-        template <typename Predicate, typename Position = size_t>
-        std::optional<Position> rposition(const Predicate& predicate)
-        {
-            constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Predicate, const OutType&>::check();
+                const InType* head = _head.get();
+                const InType* otherHead = _otherHead.get();
+                if (head && (!otherHead || !(_comparer(*otherHead, *head) < 0)))
+                {
+                    _advance = true;
+                    return head;
+                }
 
-            Position pos = Position(0);
-            while (const OutType* value = next_back())
-            {
-                if (predicate(*value))
+                if (otherHead)
                 {
-                    return pos;
+                    _advanceOther = true;
+                    return otherHead;
                 }
 
-                ++pos;
+                return nullptr;
             }
 
-            return { };
-        }
-
-
-        //
-        // Iterator functions
-        //
+            IterType _iter;
+            OtherIterType _otherIter;
+            Comparer _comparer;
+            StoredValue<InType, HasStablePointers<IterType>::value> _head;
+            StoredValue<InType, HasStablePointers<OtherIterType>::value> _otherHead;
+            bool _advance;
+            bool _advanceOther;
+        };
 
-        // Reverses the iterator, causing `next` to return elements from the back,
-        // and `next_back` to return elements from the front.
-        detail::ReverseIter<ConcreteIterType> reverse()
+        template <typename IterType, typename OtherIterType, typename KeyFunction, typename OtherKeyFunction>
+        struct HashJoinIter : public Iterator<HashJoinIter<IterType, OtherIterType, KeyFunction, OtherKeyFunction>,
+            std::pair<const typename IterType::OutType&, const typename OtherIterType::OutType&>>
         {
-            return detail::ReverseIter<ConcreteIterType>(*Iterator<ConcreteIterType, OutType>::concrete_iter());
-        }
-    };
-
-    namespace detail
-    {
-        //
-        // Iterator implementations
-        //
+            using InType = typename IterType::OutType;
+            using OtherInType = typename OtherIterType::OutType;
+            using OutType = std::pair<const InType&, const OtherInType&>;
 
-        template <typename CppIterType>
-        struct CppIteratorWrapper : public DoubleEndedIterator<CppIteratorWrapper<CppIterType>, typename ValueTypeHelper<CppIterType>::value_type>
-        {
-            using OutType = typename ValueTypeHelper<CppIterType>::value_type;
+            using KeyType = std::decay_t<typename ReturnTypeHelperConstRefOrValue<KeyFunction, const InType&>::type>;
+            using OtherKeyType = std::decay_t<typename ReturnTypeHelperConstRefOrValue<OtherKeyFunction, const OtherInType&>::type>;
+            static_assert(std::is_same_v<KeyType, OtherKeyType>, "The key functions of hash_join must return the same type.");
 
-            friend struct Iterator<CppIteratorWrapper<CppIterType>, OutType>;
-            friend struct DoubleEndedIterator<CppIteratorWrapper<CppIterType>, OutType>;
+            friend struct Iterator<HashJoinIter<IterType, OtherIterType, KeyFunction, OtherKeyFunction>, OutType>;
 
-            CppIteratorWrapper(const CppIterType& begin, const CppIterType& end) : _begin(begin), _end(end)
+            HashJoinIter(const IterType& iter, const OtherIterType& otherIter, const KeyFunction& keyFunction, const OtherKeyFunction& otherKeyFunction) :
+                _iter(iter), _otherIter(otherIter), _keyFunction(keyFunction), _otherKeyFunction(otherKeyFunction),
+                _buffer(), _otherBuffer(), _nextMatch(), _heads(), _probe(), _otherProbe(), _match(NoMatch),
+                _tmpResult(), _initialized(false), _buildFromOther(true)
             {
             }
 
         private:
+            static constexpr size_t NoMatch = ~size_t(0);
+
+            // The elements of the build side are stored in a buffer, and the hash table maps each key to the index of its first element.
+            // The elements with the same key are linked together in `_nextMatch`, in their original order.
+
             const OutType* next_impl()
             {
-                if (_begin == _end)
+                if (!_initialized)
+                {
+                    _initialized = true;
+
+                    std::optional<size_t> len = known_len(_iter);
+                    std::optional<size_t> otherLen = known_len(_otherIter);
+                    _buildFromOther = !len || !otherLen || *otherLen <= *len;
+                    if (_buildFromOther)
+                    {
+                        build(_otherIter, _otherKeyFunction, _otherBuffer, otherLen);
+                    }
+                    else
+                    {
+                        build(_iter, _keyFunction, _buffer, len);
+                    }
+                }
+
+                if (_heads.size() == 0)
                 {
+                    // nothing can match
                     return nullptr;
                 }
-                else
+
+                while (true)
                 {
-                    const OutType* current = &*_begin;
-                    ++_begin;
-                    return current;
+                    if (_match != NoMatch)
+                    {
+                        size_t index = _match;
+                        _match = _nextMatch[index];
+                        if (_buildFromOther)
+                        {
+                            _tmpResult.emplace(*_probe.get(), _otherBuffer[index]);
+                        }
+                        else
+                        {
+                            _tmpResult.emplace(_buffer[index], *_otherProbe.get());
+                        }
+
+                        return &*_tmpResult;
+                    }
+
+                    const size_t* head = nullptr;
+                    if (_buildFromOther)
+                    {
+                        const InType* probe = _iter.next();
+                        if (!probe)
+                        {
+                            return nullptr;
+                        }
+
+                        _probe.set(probe);
+                        head = _heads.find(_keyFunction(*probe));
+                    }
+                    else
+                    {
+                        const OtherInType* otherProbe = _otherIter.next();
+                        if (!otherProbe)
+                        {
+                            return nullptr;
+                        }
+
+                        _otherProbe.set(otherProbe);
+                        head = _heads.find(_otherKeyFunction(*otherProbe));
+                    }
+
+                    _match = head ? *head : NoMatch;
                 }
             }
 
-            const OutType* next_back_impl()
+            template <typename BuildIterType, typename BuildKeyFunction, typename T>
+            void build(BuildIterType& iter, const BuildKeyFunction& keyFunction, std::vector<T>& buffer, std::optional<size_t> len)
             {
-                if (_begin == _end)
+                if (len)
                 {
-                    return nullptr;
+                    buffer.reserve(*len);
+                    _heads.reserve(*len);
                 }
-                else
+
+                while (const T* value = iter.next())
                 {
-                    // If you get a compiler error here, then it's likely that the C++ iterator is
-                    // a forward iterator, which does not support bi-directional iteration.
-                    return &*--_end;
+                    buffer.push_back(*value);
+                }
+
+                // link the elements backwards, so every chain is in the original order
+                _nextMatch.resize(buffer.size(), NoMatch);
+                for (size_t i = buffer.size(); i-- > 0;)
+                {
+                    auto [head, inserted] = _heads.insert(keyFunction(buffer[i]), i);
+                    if (!inserted)
+                    {
+                        _nextMatch[i] = *head;
+                        *head = i;
+                    }
                 }
             }
 
-            CppIterType _begin;
-            CppIterType _end;
+            IterType _iter;
+            OtherIterType _otherIter;
+            KeyFunction _keyFunction;
+            OtherKeyFunction _otherKeyFunction;
+            std::vector<InType> _buffer;
+            std::vector<OtherInType> _otherBuffer;
+            std::vector<size_t> _nextMatch;
+            HashTable<KeyType, size_t> _heads;
+            // the probed element is stored, so copies of the iterator don't point into the storage of other iterators
+            StoredValue<InType, HasStablePointers<IterType>::value> _probe;
+            StoredValue<OtherInType, HasStablePointers<OtherIterType>::value> _otherProbe;
+            size_t _match;
+            std::optional<OutType> _tmpResult;
+            bool _initialized;
+            bool _buildFromOther;
         };
 
-        template <typename IterType, typename T>
-        struct StepByIter : public Iterator<StepByIter<IterType, T>, typename IterType::OutType>
+        template <typename IterType, typename OtherIterType, typename Comparer>
+        struct MergeJoinIter : public Iterator<MergeJoinIter<IterType, OtherIterType, Comparer>,
+            std::pair<const typename IterType::OutType&, const typename OtherIterType::OutType&>>
         {
             using InType = typename IterType::OutType;
-            using OutType = InType;
+            using OtherInType = typename OtherIterType::OutType;
+            using OutType = std::pair<const InType&, const OtherInType&>;
 
-            friend struct Iterator<StepByIter<IterType, T>, OutType>;
+            friend struct Iterator<MergeJoinIter<IterType, OtherIterType, Comparer>, OutType>;
 
-            StepByIter(const IterType& iter, const T& stepSize) : _iter(iter), _stepSize(stepSize), _first(true), _invalid(stepSize <= 0)
+            MergeJoinIter(const IterType& iter, const OtherIterType& otherIter, const Comparer& comparer) :
+                _iter(iter), _other(otherIter), _runBegin(), _runHead(), _comparer(comparer), _value(), _otherHead(),
+                _tmpResult(), _scanning(false), _started(false)
             {
             }
 
         private:
+            // Both iterators are advanced in place, _value and _otherHead are their current elements.
+            // The current elements are stored, so copies of the iterator don't point into the storage of other iterators.
+            // When a run of elements of the other iterator which are equal to the current element starts, its first element is stored
+            // in _runHead, and a copy of the other iterator is saved in _runBegin, so if the next element of the current iterator
+            // is equal too, then the same run can be iterated again. Otherwise the other iterator is never copied.
+            // The iterators are stored in optionals, because they are not always assignable (e.g. if they contain lambdas).
+
             const OutType* next_impl()
             {
-                if (_invalid)
+                if (!_started)
                 {
-                    return nullptr;
+                    _started = true;
+                    _value.assign(_iter.next());
+                    _otherHead.assign(_value.get() ? _other->next() : nullptr);
                 }
 
-                if (_first)
-                {
-                    _first = false;
-                    return _iter.next();
-                }
-                else
+                while (const InType* value = _value.get())
                 {
-                    const OutType* last = nullptr;
-                    for (T i = 0; i < _stepSize; ++i)
+                    if (_scanning)
                     {
-                        last = _iter.next();
+                        const OtherInType* otherValue = _other->next();
+                        if (otherValue && _comparer(*value, *otherValue) == 0)
+                        {
+                            _tmpResult.emplace(*value, *otherValue);
+                            return &*_tmpResult;
+                        }
+
+                        // the current element has no more matches
+                        _scanning = false;
+                        _otherHead.assign(otherValue);
+                        _value.assign(_iter.next());
+                        value = _value.get();
+                        if (value && _comparer(*value, *_runHead.get()) == 0)
+                        {
+                            // the next element matches the same run, so it's iterated again from the beginning
+                            _other.emplace(*_runBegin);
+                            _scanning = true;
+                            _tmpResult.emplace(*value, *_runHead.get());
+                            return &*_tmpResult;
+                        }
+
+                        continue;
                     }
 
-                    return last;
+                    const OtherInType* otherHead = _otherHead.get();
+                    if (!otherHead)
+                    {
+                        return nullptr;
+                    }
+
+                    auto compared = _comparer(*value, *otherHead);
+                    if (compared > 0)
+                    {
+                        // the other element is smaller than every remaining element, skip it
+                        _otherHead.assign(_other->next());
+                    }
+                    else if (compared < 0)
+                    {
+                        _value.assign(_iter.next());
+                    }
+                    else
+                    {
+                        _runHead.set(otherHead);
+                        _runBegin.emplace(*_other);
+                        _scanning = true;
+                        _tmpResult.emplace(*value, *_runHead.get());
+                        return &*_tmpResult;
+                    }
                 }
+
+                return nullptr;
             }
 
             IterType _iter;
-            T _stepSize;
-            bool _first;
-            bool _invalid;
+            std::optional<OtherIterType> _other;
+            std::optional<OtherIterType> _runBegin;
+            StoredValue<OtherInType, HasStablePointers<OtherIterType>::value> _runHead;
+            Comparer _comparer;
+            StoredValue<InType, HasStablePointers<IterType>::value> _value;
+            StoredValue<OtherInType, HasStablePointers<OtherIterType>::value> _otherHead;
+            std::optional<OutType> _tmpResult;
+            bool _scanning;
+            bool _started;
         };
 
-        template <typename IterType, typename ChainedIterType>
-        struct ChainIter : public Iterator<ChainIter<IterType, ChainedIterType>, typename IterType::OutType>
+        template <typename IterType, typename OtherIterType, typename Comparer, SetOperation Operation>
+        struct SetOperationIter : public Iterator<SetOperationIter<IterType, OtherIterType, Comparer, Operation>, typename IterType::OutType>
         {
             using InType = typename IterType::OutType;
             using OutType = InType;
 
-            friend struct Iterator<ChainIter<IterType, ChainedIterType>, OutType>;
+            static_assert(std::is_same_v<InType, typename OtherIterType::OutType>, "Set operations can only be used on iterators with the same element type.");
 
-            ChainIter(const IterType& iter, const ChainedIterType& chainedIter) : _iter(iter), _chainedIter(chainedIter), _firstDone(false)
+            friend struct Iterator<SetOperationIter<IterType, OtherIterType, Comparer, Operation>, OutType>;
+
+            SetOperationIter(const IterType& iter, const OtherIterType& otherIter, const Comparer& comparer) :
+                _iter(iter), _otherIter(otherIter), _comparer(comparer), _head(), _otherHead(), _advance(true), _advanceOther(true)
             {
             }
 
         private:
+            static constexpr bool YieldsOnlyInCurrent = Operation != SetOperation::Intersection;
+            static constexpr bool YieldsOnlyInOther = Operation == SetOperation::Union || Operation == SetOperation::SymmetricDifference;
+            static constexpr bool YieldsInBoth = Operation == SetOperation::Intersection || Operation == SetOperation::Union;
+
             const OutType* next_impl()
             {
-                if (!_firstDone)
+                // same as in MergeIter, the current values are stored, and an iterator is only advanced
+                // when its previous value is not needed anymore
+                while (true)
                 {
-                    const OutType* value = _iter.next();
-                    if (value != nullptr)
+                    if (_advance)
                     {
-                        return value;
+                        _head.assign(_iter.next());
+                        _advance = false;
+                    }
+
+                    if (_advanceOther)
+                    {
+                        _otherHead.assign(_otherIter.next());
+                        _advanceOther = false;
+                    }
+
+                    const InType* head = _head.get();
+                    const InType* otherHead = _otherHead.get();
+
+                    if (!head || !otherHead)
+                    {
+                        if (head && YieldsOnlyInCurrent)
+                        {
+                            _advance = true;
+                            return head;
+                        }
+
+                        if (otherHead && YieldsOnlyInOther)
+                        {
+                            _advanceOther = true;
+                            return otherHead;
+                        }
+
+                        return nullptr;
+                    }
+
+                    auto compared = _comparer(*head, *otherHead);
+                    if (compared < 0)
+                    {
+                        _advance = true;
+                        if constexpr (YieldsOnlyInCurrent)
+                        {
+                            return head;
+                        }
+                        else
+                        {
+                            skip_less(_iter, *otherHead);
+                        }
+                    }
+                    else if (compared > 0)
+                    {
+                        _advanceOther = true;
+                        if constexpr (YieldsOnlyInOther)
+                        {
+                            return otherHead;
+                        }
+                        else
+                        {
+                            skip_less(_otherIter, *head);
+                        }
                     }
                     else
                     {
-                        _firstDone = true;
+                        _advance = true;
+                        _advanceOther = true;
+                        if constexpr (YieldsInBoth)
+                        {
+                            return head;
+                        }
                     }
                 }
+            }
 
-                return _chainedIter.next();
+            // Skips the elements which are less than the given value (the value must not belong to the given iterator),
+            // if the iterator supports galloping. Otherwise the elements are skipped one by one in `next_impl`.
+            template <typename SkippedIterType>
+            void skip_less(SkippedIterType& iter, const InType& value)
+            {
+                if constexpr (IsRandomAccessIter<SkippedIterType>::value)
+                {
+                    gallop(iter, [&](const InType& element) { return _comparer(element, value) < 0; });
+                }
             }
 
             IterType _iter;
-            ChainedIterType _chainedIter;
-            bool _firstDone;
+            OtherIterType _otherIter;
+            Comparer _comparer;
+            StoredValue<InType, HasStablePointers<IterType>::value> _head;
+            StoredValue<InType, HasStablePointers<OtherIterType>::value> _otherHead;
+            bool _advance;
+            bool _advanceOther;
         };
 
-        template <typename IterType, typename ZippedIterType>
-        struct ZipIter : public Iterator<ZipIter<IterType, ZippedIterType>, std::pair<typename IterType::OutType, typename ZippedIterType::OutType>>
+        template <typename IterType, typename OtherIterType>
+        struct InterleaveIter : public Iterator<InterleaveIter<IterType, OtherIterType>, typename IterType::OutType>
         {
             using InType = typename IterType::OutType;
-            using OutType = std::pair<InType, typename ZippedIterType::OutType>;
+            using OutType = InType;
 
-            friend struct Iterator<ZipIter<IterType, ZippedIterType>, OutType>;
+            static_assert(std::is_same_v<InType, typename OtherIterType::OutType>, "Only iterators with the same element type can be interleaved.");
 
-            ZipIter(const IterType& iter, const ZippedIterType& zippedIter) : _iter(iter), _zippedIter(zippedIter), _tmpResult(), _anyDone(false)
+            friend struct Iterator<InterleaveIter<IterType, OtherIterType>, OutType>;
+
+            InterleaveIter(const IterType& iter, const OtherIterType& otherIter) :
+                _iter(iter), _otherIter(otherIter), _useOther(false), _done(false), _otherDone(false)
             {
             }
 
         private:
             const OutType* next_impl()
             {
-                if (_anyDone)
+                // if the iterator whose turn it is has finished, then the other one is tried, finished iterators are never advanced again
+                for (int attempt = 0; attempt < 2; ++attempt)
                 {
-                    return nullptr;
-                }
+                    bool useOther = _useOther;
+                    _useOther = !_useOther;
+                    if (useOther)
+                    {
+                        if (!_otherDone)
+                        {
+                            if (const OutType* value = _otherIter.next())
+                            {
+                                return value;
+                            }
 
-                const InType* value = _iter.next();
-                const typename ZippedIterType::OutType* zippedValue = _zippedIter.next();
+                            _otherDone = true;
+                        }
+                    }
+                    else if (!_done)
+                    {
+                        if (const OutType* value = _iter.next())
+                        {
+                            return value;
+                        }
 
-                if (value == nullptr || zippedValue == nullptr)
-                {
-                    // return null if any of the iterators are finished
-                    _anyDone = true;
-                    return nullptr;
+                        _done = true;
+                    }
                 }
 
-                _tmpResult = { *value, *zippedValue };
-                return &_tmpResult;
+                return nullptr;
             }
 
             IterType _iter;
-            ZippedIterType _zippedIter;
-            OutType _tmpResult;
-            bool _anyDone;
+            OtherIterType _otherIter;
+            bool _useOther;
+            bool _done;
+            bool _otherDone;
         };
 
-        template <typename IterType, typename SeparatorGetter>
-        struct IntersperseWithIter : public Iterator<IntersperseWithIter<IterType, SeparatorGetter>, typename IterType::OutType>
+        template <typename IterType>
+        struct RoundRobinIter : public Iterator<RoundRobinIter<IterType>, typename IterType::OutType>
         {
             using InType = typename IterType::OutType;
             using OutType = InType;
 
-            friend struct Iterator<IntersperseWithIter<IterType, SeparatorGetter>, OutType>;
+            friend struct Iterator<RoundRobinIter<IterType>, OutType>;
 
-            IntersperseWithIter(const IterType& iter, const SeparatorGetter& separatorGetter) :
-                _iter(iter), _separatorGetter(separatorGetter), _tmpResult(), _nextResult(), _separatorIsNext(false)
+            RoundRobinIter(const std::vector<IterType>& iters) :
+                _iters(iters), _nextActive(iters.size()), _current(0), _previous(iters.empty() ? 0 : iters.size() - 1), _activeCount(iters.size())
             {
-                if (const OutType* next = _iter.next())
+                for (size_t i = 0; i < _iters.size(); ++i)
                 {
-                    // get the next result immediately, so that we can know if the iterator is empty or not
-                    _nextResult = *next;
+                    _nextActive[i] = i + 1 == _iters.size() ? 0 : i + 1;
                 }
             }
 
         private:
+            // The iterators which are not finished yet form a circular linked list in _nextActive,
+            // so a finished iterator is removed in O(1) time, and it's never checked again.
+
             const OutType* next_impl()
             {
-                if (_separatorIsNext)
-                {
-                    _separatorIsNext = false;
-                    _tmpSeparator = _separatorGetter();
-                    return &*_tmpSeparator;
-                }
-                else
+                while (_activeCount != 0)
                 {
-                    if (_nextResult)
+                    size_t index = _current;
+                    _current = _nextActive[index];
+                    if (const OutType* value = _iters[index].next())
                     {
-                        _tmpResult = *_nextResult;
-
-                        // check if we have a next element
-                        // if yes, then we need to insert a separator in the next call
-
-                        if (const OutType* next = _iter.next())
-                        {
-                            _nextResult = *next;
-                            _separatorIsNext = true;
-                        }
-                        else
-                        {
-                            _nextResult.reset();
-                        }
-
-                        return &*_tmpResult;
+                        _previous = index;
+                        return value;
                     }
 
-                    return nullptr;
+                    _nextActive[_previous] = _current;
+                    --_activeCount;
                 }
+
+                return nullptr;
             }
 
-            IterType _iter;
-            SeparatorGetter _separatorGetter;
-            std::optional<OutType> _tmpSeparator;
-            std::optional<OutType> _tmpResult;
-            std::optional<OutType> _nextResult;
-            bool _separatorIsNext;
+            std::vector<IterType> _iters;
+            std::vector<size_t> _nextActive;
+            size_t _current;
+            size_t _previous;
+            size_t _activeCount;
         };
 
-        template <typename IterType, typename MapFunction>
-        struct MapIter : public Iterator<MapIter<IterType, MapFunction>, typename ReturnTypeHelperConstRefOrValue<MapFunction, typename IterType::OutType>::type>
+        template <typename IterType, typename Comparer>
+        struct KMergeIter : public Iterator<KMergeIter<IterType, Comparer>, typename IterType::OutType>
         {
             using InType = typename IterType::OutType;
-            using OutType = typename ReturnTypeHelperConstRefOrValue<MapFunction, InType>::type;
+            using OutType = InType;
 
-            friend struct Iterator<MapIter<IterType, MapFunction>, OutType>;
+            friend struct Iterator<KMergeIter<IterType, Comparer>, OutType>;
 
-            MapIter(const IterType& iter, const MapFunction& mapFunction) : _iter(iter), _mapFunction(mapFunction), _tmpResult()
+            KMergeIter(const std::vector<IterType>& iters, const Comparer& comparer) :
+                _iters(iters), _comparer(comparer), _heads(), _tree(), _initialized(false)
             {
             }
 
         private:
+            // The iterators are merged using a tournament tree of losers.
+            // _tree[0] is the index of the iterator with the smallest current value (the winner),
+            // and each internal node (1 to k - 1) stores the loser of the match played at that node.
+            // The leaves are not stored, leaf i is at the (virtual) node k + i.
+            // This way, only the matches on the path from the winner's leaf to the root must be replayed when its value changes,
+            // which is log2(k) comparisons per element.
+
             const OutType* next_impl()
             {
-                if (const InType* current = _iter.next())
+                size_t count = _iters.size();
+                if (count == 0)
                 {
-                    _tmpResult = _mapFunction(*current);
-                    return &*_tmpResult;
+                    return nullptr;
                 }
-                else
+
+                if (!_initialized)
                 {
-                    return nullptr;
+                    _initialized = true;
+                    _heads.resize(count);
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        _heads[i].assign(_iters[i].next());
+                    }
+
+                    _tree.resize(count);
+                    _tree[0] = build(1);
                 }
-            }
+                else
+                {
+                    // the winner was yielded in the previous call, so it can be advanced now
+                    size_t winner = _tree[0];
+                    _heads[winner].assign(_iters[winner].next());
 
-            IterType _iter;
-            MapFunction _mapFunction;
-            std::optional<OutType> _tmpResult;
-        };
+                    for (size_t node = (winner + count) / 2; node > 0; node /= 2)
+                    {
+                        if (less(_tree[node], winner))
+                        {
+                            std::swap(_tree[node], winner);
+                        }
+                    }
 
-        template <typename IterType, typename FilterFunction>
-        struct FilterIter : public Iterator<FilterIter<IterType, FilterFunction>, typename IterType::OutType>
-        {
-            using InType = typename IterType::OutType;
-            using OutType = InType;
+                    _tree[0] = winner;
+                }
 
-            friend struct Iterator<FilterIter<IterType, FilterFunction>, OutType>;
+                return _heads[_tree[0]].get();
+            }
 
-            FilterIter(const IterType& iter, const FilterFunction& filterFunction) : _iter(iter), _filterFunction(filterFunction)
+            // Plays all matches in the subtree of the given node, and returns the winner.
+            size_t build(size_t node)
             {
+                size_t count = _iters.size();
+                if (node >= count)
+                {
+                    return node - count;
+                }
+
+                size_t left = build(node * 2);
+                size_t right = build(node * 2 + 1);
+                if (less(right, left))
+                {
+                    _tree[node] = left;
+                    return right;
+                }
+                else
+                {
+                    _tree[node] = right;
+                    return left;
+                }
             }
 
-        private:
-            const OutType* next_impl()
+            // Returns true if iterator a's current value should be yielded before iterator b's.
+            // Finished iterators are greater than everything, and equal values are ordered by their iterator's index.
+            bool less(size_t a, size_t b) const
             {
-                while (const InType* current = _iter.next())
+                const InType* headA = _heads[a].get();
+                const InType* headB = _heads[b].get();
+                if (!headA)
                 {
-                    if (_filterFunction(*current))
-                    {
-                        return current;
-                    }
+                    return false;
                 }
 
-                return nullptr;
+                if (!headB)
+                {
+                    return true;
+                }
+
+                auto compared = _comparer(*headA, *headB);
+                return compared < 0 || (!(compared > 0) && a < b);
             }
 
-            IterType _iter;
-            FilterFunction _filterFunction;
+            std::vector<IterType> _iters;
+            Comparer _comparer;
+            // same as in MergeIter, the values are stored, so they don't point into the iterators of another copy of this iterator
+            std::vector<StoredValue<InType, HasStablePointers<IterType>::value>> _heads;
+            std::vector<size_t> _tree;
+            bool _initialized;
         };
 
-        // if you get a compile error here, then it's likely that your filterMapFunction doesn't return an std::optional value
-        template <typename IterType, typename FilterMapFunction>
-        struct FilterMapIter : public Iterator<FilterMapIter<IterType, FilterMapFunction>, typename ReturnTypeHelperConstRefOrValue<FilterMapFunction, typename IterType::OutType>::type::value_type>
+        template <typename IterType, typename OtherIterType>
+        struct CartesianProductIter : public Iterator<CartesianProductIter<IterType, OtherIterType>,
+            std::pair<const typename IterType::OutType&, const typename OtherIterType::OutType&>>
         {
             using InType = typename IterType::OutType;
-            using OutType = typename ReturnTypeHelperConstRefOrValue<FilterMapFunction, InType>::type::value_type;
+            using OtherInType = typename OtherIterType::OutType;
+            using OutType = std::pair<const InType&, const OtherInType&>;
 
-            friend struct Iterator<FilterMapIter<IterType, FilterMapFunction>, OutType>;
+            friend struct Iterator<CartesianProductIter<IterType, OtherIterType>, OutType>;
 
-            FilterMapIter(const IterType& iter, const FilterMapFunction& filterMapFunction) : _iter(iter), _filterMapFunction(filterMapFunction), _tmpResult()
+            CartesianProductIter(const IterType& iter, const OtherIterType& otherIter) :
+                _iter(iter), _otherIter(otherIter), _buffer(), _value(), _index(0), _tmpResult(), _initialized(false)
             {
             }
 
+            // Returns the exact number of remaining pairs.
+            // Only available if the length of the current iterator is known (see `rusty::is_random_access_v`).
+            // The other iterator is collected into the buffer, if that didn't happen yet.
+            size_t len()
+            {
+                static_assert(IsRandomAccessIter<IterType>::value, "len can only be used if the current iterator is a random access iterator.");
+
+                initialize();
+                size_t currentRemaining = _value.get() ? _buffer.size() - _index : 0;
+                return currentRemaining + _iter.len() * _buffer.size();
+            }
+
         private:
             const OutType* next_impl()
             {
-                while (const InType* current = _iter.next())
+                initialize();
+                if (_buffer.empty())
                 {
-                    std::optional<OutType> result = _filterMapFunction(*current);
-                    if (result)
+                    return nullptr;
+                }
+
+                if (!_value.get() || _index == _buffer.size())
+                {
+                    _value.assign(_iter.next());
+                    _index = 0;
+                    if (!_value.get())
                     {
-                        _tmpResult = *result;
-                        return &_tmpResult;
+                        return nullptr;
                     }
                 }
 
-                return nullptr;
+                _tmpResult.emplace(*_value.get(), _buffer[_index++]);
+                return &*_tmpResult;
+            }
+
+            void initialize()
+            {
+                if (_initialized)
+                {
+                    return;
+                }
+
+                _initialized = true;
+                if (std::optional<size_t> len = known_len(_otherIter))
+                {
+                    _buffer.reserve(*len);
+                }
+
+                while (const OtherInType* value = _otherIter.next())
+                {
+                    _buffer.push_back(*value);
+                }
             }
 
             IterType _iter;
-            FilterMapFunction _filterMapFunction;
-            OutType _tmpResult;
+            OtherIterType _otherIter;
+            std::vector<OtherInType> _buffer;
+            // the current element is stored, so copies of the iterator don't point into the storage of other iterators
+            StoredValue<InType, HasStablePointers<IterType>::value> _value;
+            size_t _index;
+            std::optional<OutType> _tmpResult;
+            bool _initialized;
         };
 
+        // Shared implementation of CombinationsIter and PermutationsIter: collects the elements into a buffer,
+        // and yields the elements at the indices generated by the derived class as a vector of references.
         template <typename IterType>
-        struct PeekableIter : public Iterator<PeekableIter<IterType>, typename IterType::OutType>
+        struct IndexedSelection
         {
             using InType = typename IterType::OutType;
-            using OutType = InType;
+            using OutType = std::vector<std::reference_wrapper<const InType>>;
 
-            friend struct Iterator<PeekableIter<IterType>, OutType>;
-
-            PeekableIter(const IterType& iter) : _iter(iter), _nextItem(), _tmpResult()
+            IndexedSelection(const IterType& iter, size_t k) :
+                _iter(iter), _k(k), _buffer(), _indices(), _remaining(0), _tmpResult(), _initialized(false), _started(false), _done(false)
             {
             }
 
-            // Returns the next item, without advancing the iterator.
-            // Returns null if there are no more elements.
-            const OutType* peek()
+        protected:
+            // Collects the elements into the buffer, and returns true if it happened now.
+            bool fill_buffer()
             {
-                if (!_nextItem)
+                if (_initialized)
                 {
-                    // next item is unknown, get it from the iter
-                    if (const OutType* next = _iter.next())
-                    {
-                        // iter still has values
-                        _nextItem.emplace(*next);
-                    }
-                    else
-                    {
-                        // iter has finished, no more values
-                        _nextItem.reset();
-                        return nullptr;
-                    }
+                    return false;
                 }
 
-                std::optional<OutType>& nextValue = *_nextItem;
-                if (nextValue)
+                _initialized = true;
+                if (std::optional<size_t> len = known_len(_iter))
                 {
-                    // next item is known, and has value
-                    return &*nextValue;
+                    _buffer.reserve(*len);
                 }
-                else
+
+                while (const InType* value = _iter.next())
                 {
-                    // next item is known, but has no value
-                    return nullptr;
+                    _buffer.push_back(*value);
                 }
+
+                return true;
             }
 
-        private:
-            const OutType* next_impl()
+            const OutType* yield_indices()
             {
-                if (_nextItem)
+                // the number of remaining selections is only tracked for `len`, the end is detected from the indices,
+                // so the count can saturate without affecting the iteration
+                if (_remaining != std::numeric_limits<size_t>::max())
                 {
-                    // next item was already peeked
-
-                    _tmpResult = *_nextItem;
-                    _nextItem.reset();
+                    --_remaining;
+                }
 
-                    if (_tmpResult)
-                    {
-                        return &*_tmpResult;
-                    }
-                    else
-                    {
-                        return nullptr;
-                    }
+                _tmpResult.clear();
+                for (size_t i = 0; i < _k; ++i)
+                {
+                    _tmpResult.push_back(std::cref(_buffer[_indices[i]]));
                 }
 
-                // next item was not peeked, just return the next item from the iter
-                return _iter.next();
+                return &_tmpResult;
             }
 
             IterType _iter;
-            std::optional<std::optional<OutType>> _nextItem;
-            std::optional<OutType> _tmpResult;
+            size_t _k;
+            std::vector<InType> _buffer;
+            std::vector<size_t> _indices;
+            size_t _remaining;
+            OutType _tmpResult;
+            bool _initialized;
+            bool _started;
+            bool _done;
         };
 
-        template <typename IterType, typename Predicate>
-        struct SkipWhileIter : public Iterator<SkipWhileIter<IterType, Predicate>, typename IterType::OutType>
+        template <typename IterType>
+        struct CombinationsIter : public Iterator<CombinationsIter<IterType>, std::vector<std::reference_wrapper<const typename IterType::OutType>>>,
+            private IndexedSelection<IterType>
         {
-            using InType = typename IterType::OutType;
-            using OutType = InType;
+            using Base = IndexedSelection<IterType>;
+            using InType = typename Base::InType;
+            using OutType = typename Base::OutType;
 
-            friend struct Iterator<SkipWhileIter<IterType, Predicate>, OutType>;
+            friend struct Iterator<CombinationsIter<IterType>, OutType>;
 
-            SkipWhileIter(const IterType& iter, const Predicate& predicate) : _iter(iter), _predicate(predicate), _done(false)
+            CombinationsIter(const IterType& iter, size_t k) : Base(iter, k)
+            {
+            }
+
+            // Returns the exact number of remaining combinations.
+            // If the number doesn't fit in size_t, then the maximum value of size_t is returned.
+            // The elements are collected into the buffer, if that didn't happen yet.
+            size_t len()
             {
+                initialize();
+                return this->_remaining;
             }
 
         private:
+            // The indices are always increasing, and the next combination is found by incrementing
+            // the last index which can still be incremented, then resetting the indices after it.
+
             const OutType* next_impl()
             {
-                if (!_done)
+                initialize();
+                if (this->_done)
                 {
-                    _done = true;
+                    return nullptr;
+                }
 
-                    while (const OutType* value = _iter.next())
-                    {
-                        if (!_predicate(*value))
-                        {
-                            return value;
-                        }
-                    }
+                if (!this->_started)
+                {
+                    this->_started = true;
+                    return this->yield_indices();
+                }
+
+                std::vector<size_t>& indices = this->_indices;
+                size_t n = this->_buffer.size();
+                size_t k = this->_k;
+
+                size_t i = k;
+                while (i > 0 && indices[i - 1] == i - 1 + n - k)
+                {
+                    --i;
+                }
 
+                if (i == 0)
+                {
+                    // every index is at its last possible position, this was the last combination
+                    this->_done = true;
                     return nullptr;
                 }
 
-                return _iter.next();
-            }
+                ++indices[i - 1];
+                for (size_t j = i; j < k; ++j)
+                {
+                    indices[j] = indices[j - 1] + 1;
+                }
 
-            IterType _iter;
-            Predicate _predicate;
-            bool _done;
-        };
+                return this->yield_indices();
+            }
 
-        template <typename IterType, typename Predicate>
-        struct TakeWhileIter : public Iterator<TakeWhileIter<IterType, Predicate>, typename IterType::OutType>
-        {
-            using InType = typename IterType::OutType;
-            using OutType = InType;
+            void initialize()
+            {
+                if (!this->fill_buffer())
+                {
+                    return;
+                }
 
-            friend struct Iterator<TakeWhileIter<IterType, Predicate>, OutType>;
+                size_t n = this->_buffer.size();
+                size_t k = this->_k;
+                if (k > n)
+                {
+                    this->_done = true;
+                    return;
+                }
 
-            TakeWhileIter(const IterType& iter, const Predicate& predicate) : _iter(iter), _predicate(predicate), _done(false)
-            {
+                this->_remaining = binomial(n, k);
+                for (size_t i = 0; i < k; ++i)
+                {
+                    this->_indices.push_back(i);
+                }
             }
 
-        private:
-            const OutType* next_impl()
+            // Returns n choose k, or the maximum value of size_t if it doesn't fit in it.
+            // Every intermediate result is a binomial coefficient, so the divisions are exact, and (i + 1) / gcd divides (n - i),
+            // so the intermediate results only overflow if the final one does too (because of the symmetry, k <= n / 2,
+            // and the coefficients are increasing).
+            static size_t binomial(size_t n, size_t k)
             {
-                if (_done)
+                if (k > n - k)
                 {
-                    return nullptr;
+                    k = n - k;
                 }
 
-                if (const OutType* value = _iter.next())
+                size_t result = 1;
+                for (size_t i = 0; i < k; ++i)
                 {
-                    if (_predicate(*value))
+                    size_t divisor = std::gcd(result, i + 1);
+                    result = saturating_mul(result / divisor, (n - i) / ((i + 1) / divisor));
+                    if (result == std::numeric_limits<size_t>::max())
                     {
-                        return value;
+                        break;
                     }
                 }
 
-                _done = true;
-                return nullptr;
+                return result;
             }
-
-            IterType _iter;
-            Predicate _predicate;
-            bool _done;
         };
 
         template <typename IterType>
-        struct FlattenIter : Iterator<FlattenIter<IterType>, typename IterType::OutType::OutType>
+        struct PermutationsIter : public Iterator<PermutationsIter<IterType>, std::vector<std::reference_wrapper<const typename IterType::OutType>>>,
+            private IndexedSelection<IterType>
         {
-            using InnerIterType = typename IterType::OutType;
-            using InType = IterType;
-            using OutType = typename InnerIterType::OutType;
+            using Base = IndexedSelection<IterType>;
+            using InType = typename Base::InType;
+            using OutType = typename Base::OutType;
 
-            friend struct Iterator<FlattenIter<IterType>, OutType>;
+            friend struct Iterator<PermutationsIter<IterType>, OutType>;
 
-            FlattenIter(const IterType& iter) : _iter(iter), _innerIter()
+            PermutationsIter(const IterType& iter, size_t k) : Base(iter, k), _cycles()
             {
-                advance();
+            }
+
+            // Returns the exact number of remaining permutations.
+            // If the number doesn't fit in size_t, then the maximum value of size_t is returned.
+            // The elements are collected into the buffer, if that didn't happen yet.
+            size_t len()
+            {
+                initialize();
+                return this->_remaining;
             }
 
         private:
+            // The first k indices form the current permutation, the rest are the unused indices, in order.
+            // _cycles[i] counts how many more values position i can take before position i - 1 has to change.
+
             const OutType* next_impl()
             {
-                if (!_innerIter)
+                initialize();
+                if (this->_done)
                 {
                     return nullptr;
                 }
 
-                while (true)
+                if (!this->_started)
                 {
-                    if (const OutType* value = _innerIter->next())
+                    this->_started = true;
+                    return this->yield_indices();
+                }
+
+                std::vector<size_t>& indices = this->_indices;
+                size_t n = indices.size();
+                for (size_t i = this->_k; i-- > 0;)
+                {
+                    if (--_cycles[i] == 0)
                     {
-                        return value;
+                        // all values were used at position i, move it to the end, so the unused indices are in order again
+                        std::rotate(indices.begin() + i, indices.begin() + i + 1, indices.end());
+                        _cycles[i] = n - i;
                     }
                     else
                     {
-                        if (!advance())
-                        {
-                            return nullptr;
-                        }
+                        std::swap(indices[i], indices[n - _cycles[i]]);
+                        return this->yield_indices();
                     }
                 }
+
+                // every position went through all of its values, and the indices are back in their initial order
+                this->_done = true;
+                return nullptr;
             }
 
-            bool advance()
+            void initialize()
             {
-                if (const InnerIterType* inner = _iter.next())
+                if (!this->fill_buffer())
                 {
-                    _innerIter = *inner;
-                    return true;
+                    return;
                 }
-                else
+
+                size_t n = this->_buffer.size();
+                size_t k = this->_k;
+                if (k > n)
                 {
-                    _innerIter.reset();
-                    return false;
+                    this->_done = true;
+                    return;
+                }
+
+                // n! / (n - k)!
+                this->_remaining = 1;
+                for (size_t i = 0; i < k; ++i)
+                {
+                    this->_remaining = saturating_mul(this->_remaining, n - i);
+                    _cycles.push_back(n - i);
+                }
+
+                for (size_t i = 0; i < n; ++i)
+                {
+                    this->_indices.push_back(i);
                 }
             }
 
-            IterType _iter;
-            std::optional<InnerIterType> _innerIter;
+            std::vector<size_t> _cycles;
         };
 
-        template <typename IterType, typename InspectCallback>
-        struct InspectIter : public Iterator<InspectIter<IterType, InspectCallback>, typename IterType::OutType>
+        template <typename IterType, size_t N>
+        struct TeeIter : public Iterator<TeeIter<IterType, N>, typename IterType::OutType>
         {
             using InType = typename IterType::OutType;
             using OutType = InType;
 
-            friend struct Iterator<InspectIter<IterType, InspectCallback>, OutType>;
+            friend struct Iterator<TeeIter<IterType, N>, OutType>;
 
-            InspectIter(const IterType& iter, const InspectCallback& inspectCallback) : _iter(iter), _inspectCallback(inspectCallback)
+            // The state shared by all iterators: the elements which were yielded by the upstream iterator,
+            // but not yet by all tee iterators, are stored in a buffer. _positions contains the index of the next element
+            // for each tee iterator, and _bufferStart is the index of the first buffered element.
+            struct State
             {
+                State(const IterType& iter) : _iter(iter), _buffer(), _bufferStart(0), _positions(), _done(false)
+                {
+                    _positions.fill(0);
+                }
+
+                IterType _iter;
+                std::deque<StoredValue<InType, HasStablePointers<IterType>::value>> _buffer;
+                size_t _bufferStart;
+                std::array<size_t, N> _positions;
+                bool _done;
+            };
+
+            TeeIter(const std::shared_ptr<State>& state, size_t index) : _state(state), _index(index)
+            {
+            }
+
+            template <size_t... Indices>
+            static std::array<TeeIter, N> create_all(const std::shared_ptr<State>& state, std::index_sequence<Indices...>)
+            {
+                return { TeeIter(state, Indices)... };
             }
 
         private:
             const OutType* next_impl()
             {
-                const OutType* value = _iter.next();
-                if (value)
+                State& state = *_state;
+                size_t position = state._positions[_index];
+                if (position == state._bufferStart + state._buffer.size())
                 {
-                    _inspectCallback(*value);
+                    // this is the leading iterator, get a new element from upstream
+                    if (state._done)
+                    {
+                        return nullptr;
+                    }
+
+                    const InType* value = state._iter.next();
+                    if (!value)
+                    {
+                        state._done = true;
+                        return nullptr;
+                    }
+
+                    state._buffer.emplace_back();
+                    state._buffer.back().set(value);
                 }
 
-                return value;
+                const InType* result = state._buffer[position - state._bufferStart].get();
+                state._positions[_index] = position + 1;
+
+                // remove the elements which were yielded by all iterators, except for the last yielded element of each iterator,
+                // because those must stay valid until that iterator is advanced again
+                // (references to the other elements of a deque are not invalidated by removing elements from the front)
+                size_t minPosition = *std::min_element(state._positions.begin(), state._positions.end());
+                while (state._bufferStart + 1 < minPosition)
+                {
+                    state._buffer.pop_front();
+                    ++state._bufferStart;
+                }
+
+                return result;
             }
 
-            IterType _iter;
-            InspectCallback _inspectCallback;
+            std::shared_ptr<State> _state;
+            size_t _index;
         };
 
-        template <typename IterType>
-        struct CycleIter : public Iterator<CycleIter<IterType>, typename IterType::OutType>
+        template <typename IterType, typename Comparer>
+        struct SortedLazyIter : public Iterator<SortedLazyIter<IterType, Comparer>, typename IterType::OutType>
         {
             using InType = typename IterType::OutType;
             using OutType = InType;
 
-            friend struct Iterator<CycleIter<IterType>, OutType>;
+            friend struct Iterator<SortedLazyIter<IterType, Comparer>, OutType>;
 
-            CycleIter(const IterType& iter) : _originalIter(iter), _iter(iter), _iterIsEmpty(true)
+            SortedLazyIter(const IterType& iter, const Comparer& comparer) :
+                _iter(iter), _comparer(comparer), _buffer(), _finalBlocks(), _position(0), _sortedEnd(0), _heapEnd(0),
+                _depth(0), _maxDepth(0), _initialized(false)
             {
             }
 
         private:
+            // segments which are at most this long are sorted at once, instead of being partitioned further
+            static constexpr size_t SmallSegmentSize = 16;
+
+            struct FinalBlock
+            {
+                size_t begin;
+                size_t end;
+
+                // the partition depth of the segment which contained this block
+                size_t depth;
+            };
+
+            // Incremental quicksort: the unsorted part of the buffer which starts at the current position is partitioned
+            // until the element at the current position is in its final place, and the pivots are remembered,
+            // so later partitions only need to process the segment before the next pivot.
+            // _finalBlocks is a stack of ranges of elements which are already in their final place
+            // (the elements equal to a pivot), the top of the stack is the leftmost one.
+            // All elements before _sortedEnd are sorted.
+            // Same as for introselect, if a segment is partitioned too many times (which only happens for bad pivots),
+            // then the segment is turned into a heap instead, and its elements are popped from the heap one by one,
+            // so the worst case is O(n * log(n)) in total. The heap is [_position, _heapEnd), with its root at the end.
+
             const OutType* next_impl()
             {
-                if (const OutType* value = _iter.next())
+                if (!_initialized)
                 {
-                    _iterIsEmpty = false;
-                    return value;
+                    _initialized = true;
+                    if (std::optional<size_t> len = known_len(_iter))
+                    {
+                        _buffer.reserve(*len);
+                    }
+
+                    while (const InType* value = _iter.next())
+                    {
+                        _buffer.push_back(*value);
+                    }
+
+                    _finalBlocks.push_back(FinalBlock{ _buffer.size(), _buffer.size(), 0 });
+                    _maxDepth = 2 * static_cast<size_t>(64 - leading_zeros64(_buffer.size()));
                 }
 
-                if (_iterIsEmpty)
+                if (_position >= _buffer.size())
                 {
                     return nullptr;
                 }
 
-                // lambdas don't have a copy assignment operator, so if there is a lambda in the iterator chain,
-                // then this will cause a compiler error:
-                // _iter = _originalIter;
-                // instead, we have to use the copy constructor, which works just fine (also call the destructor before)
-                _iter.~IterType();
-                new (&_iter) IterType(_originalIter);
+                auto less = [&](const InType& a, const InType& b) { return _comparer(a, b) < 0; };
+                auto greater = [&](const InType& a, const InType& b) { return _comparer(a, b) > 0; };
 
-                return _iter.next();
+                while (_position >= _sortedEnd)
+                {
+                    const FinalBlock& block = _finalBlocks.back();
+                    if (_position < _heapEnd)
+                    {
+                        // the heap is stored in reverse order, so popping the smallest element moves it to the current position
+                        std::pop_heap(std::make_reverse_iterator(_buffer.begin() + _heapEnd), std::make_reverse_iterator(_buffer.begin() + _position), greater);
+                        _sortedEnd = _position + 1;
+                    }
+                    else if (block.begin == _position)
+                    {
+                        // the next segment is the part after the pivot, so it's one level deeper than the partitioned segment
+                        _depth = block.depth + 1;
+                        _sortedEnd = block.end;
+                        _finalBlocks.pop_back();
+                    }
+                    else if (block.begin - _position <= SmallSegmentSize)
+                    {
+                        std::sort(_buffer.begin() + _position, _buffer.begin() + block.begin, less);
+                        _sortedEnd = block.begin;
+                    }
+                    else if (_depth >= _maxDepth)
+                    {
+                        _heapEnd = block.begin;
+                        std::make_heap(std::make_reverse_iterator(_buffer.begin() + _heapEnd), std::make_reverse_iterator(_buffer.begin() + _position), greater);
+                    }
+                    else
+                    {
+                        auto [equalBegin, equalEnd] = partition(_position, block.begin);
+                        _finalBlocks.push_back(FinalBlock{ equalBegin, equalEnd, _depth });
+                        ++_depth;
+                    }
+                }
+
+                return &_buffer[_position++];
+            }
+
+            // Partitions the given range into three parts: elements less than, equal to, and greater than the pivot.
+            // Returns the range of the elements that are equal to the pivot.
+            std::pair<size_t, size_t> partition(size_t begin, size_t end)
+            {
+                // median of three
+                size_t mid = begin + (end - begin) / 2;
+                size_t last = end - 1;
+                if (_comparer(_buffer[mid], _buffer[begin]) < 0)
+                {
+                    std::swap(_buffer[mid], _buffer[begin]);
+                }
+
+                if (_comparer(_buffer[last], _buffer[begin]) < 0)
+                {
+                    std::swap(_buffer[last], _buffer[begin]);
+                }
+
+                if (_comparer(_buffer[last], _buffer[mid]) < 0)
+                {
+                    std::swap(_buffer[last], _buffer[mid]);
+                }
+
+                InType pivot = _buffer[mid];
+
+                size_t less = begin;
+                size_t i = begin;
+                size_t greater = end;
+                while (i < greater)
+                {
+                    auto compared = _comparer(_buffer[i], pivot);
+                    if (compared < 0)
+                    {
+                        std::swap(_buffer[less++], _buffer[i++]);
+                    }
+                    else if (compared > 0)
+                    {
+                        std::swap(_buffer[i], _buffer[--greater]);
+                    }
+                    else
+                    {
+                        ++i;
+                    }
+                }
+
+                return { less, greater };
             }
 
-            IterType _originalIter;
             IterType _iter;
-            bool _iterIsEmpty;
+            Comparer _comparer;
+            std::vector<InType> _buffer;
+            std::vector<FinalBlock> _finalBlocks;
+            size_t _position;
+            size_t _sortedEnd;
+            size_t _heapEnd;
+            size_t _depth;
+            size_t _maxDepth;
+            bool _initialized;
         };
 
         template <typename GeneratorFunction>
@@ -2300,6 +7186,55 @@ namespace rusty
         return iter(collection.begin(), collection.end());
     }
 
+    // Merges two sorted iterators into one sorted iterator, comparing elements with the < and > operators.
+    // Equivalent to `first.merge(second)`.
+    template <typename IterType, typename OtherIterType>
+    detail::MergeIter<IterType, OtherIterType, detail::Comparison> merge(const IterType& first, const OtherIterType& second)
+    {
+        return detail::MergeIter<IterType, OtherIterType, detail::Comparison>(first, second, detail::Comparison());
+    }
+
+    // Merges two sorted iterators into one sorted iterator, comparing elements with the provided comparer function.
+    // Equivalent to `first.merge_by(second, comparer)`.
+    template <typename IterType, typename OtherIterType, typename Comparer>
+    detail::MergeIter<IterType, OtherIterType, Comparer> merge_by(const IterType& first, const OtherIterType& second, const Comparer& comparer)
+    {
+        return detail::MergeIter<IterType, OtherIterType, Comparer>(first, second, comparer);
+    }
+
+    // Merges any number of sorted iterators (of the same type) into one sorted iterator, comparing elements with the < and > operators.
+    // The iterators are merged using a tournament tree, so yielding each element takes about log2(k) comparisons for k iterators.
+    // Equal elements are yielded in the order of their iterators in the vector, so the merge is stable.
+    template <typename IterType>
+    detail::KMergeIter<IterType, detail::Comparison> kmerge(const std::vector<IterType>& iters)
+    {
+        return detail::KMergeIter<IterType, detail::Comparison>(iters, detail::Comparison());
+    }
+
+    // Same as `kmerge`, but the elements are compared with the provided comparer function.
+    template <typename IterType, typename Comparer>
+    detail::KMergeIter<IterType, Comparer> kmerge_by(const std::vector<IterType>& iters, const Comparer& comparer)
+    {
+        constexpr bool typeCheck = detail::ReturnTypeHelperConstRefOrValue<Comparer, const typename IterType::OutType&, const typename IterType::OutType&>::check();
+
+        return detail::KMergeIter<IterType, Comparer>(iters, comparer);
+    }
+
+    // Creates an iterator that yields one element from each iterator in turn, in the order of the vector.
+    // Finished iterators are removed from the rotation, so the remaining ones continue fairly, without checking the finished ones again.
+    template <typename IterType>
+    detail::RoundRobinIter<IterType> round_robin(const std::vector<IterType>& iters)
+    {
+        return detail::RoundRobinIter<IterType>(iters);
+    }
+
+    // Same as the other `round_robin`, but the iterators can be provided as a list, e.g. `rusty::round_robin({ first, second, third })`.
+    template <typename IterType>
+    detail::RoundRobinIter<IterType> round_robin(std::initializer_list<IterType> iters)
+    {
+        return detail::RoundRobinIter<IterType>(std::vector<IterType>(iters));
+    }
+
     // Creates an infinite iterator which yields elements by repeatedly calling the provided generator function.
     template <typename GeneratorFunction>
     detail::GeneratorIter<GeneratorFunction> infinite_generator(const GeneratorFunction& generatorFunction)
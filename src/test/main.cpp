@@ -5,7 +5,9 @@
 #include <sstream>
 #include <string>
 #include <list>
+#include <deque>
 #include <limits>
+#include <array>
 
 struct TestCase
 {
@@ -947,6 +949,753 @@ void test_cycle(TestCase& testCase)
     ), "cycle, with lambda");
 }
 
+template <typename T>
+std::vector<T> slice_to_vector(const rusty::Slice<T>& slice)
+{
+    return std::vector<T>(slice.begin(), slice.end());
+}
+
+void test_chunks(TestCase& testCase)
+{
+    std::vector<int> numbers = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+    testCase(test_iter(
+        rusty::iter(numbers).chunks(3).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 }, { 9 } }
+    ), "chunks, from vector");
+
+    testCase(test_iter(
+        rusty::range(0, 10).chunks(3).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 }, { 9 } }
+    ), "chunks, from range");
+
+    testCase(test_iter(
+        rusty::range(0, 10).chunks(5).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2, 3, 4 }, { 5, 6, 7, 8, 9 } }
+    ), "chunks, divisible");
+
+    testCase(test_iter(rusty::range(0, 10).chunks(0).map(&slice_to_vector<int>), std::vector<std::vector<int>>{ }), "chunks, size 0");
+    testCase(test_iter(rusty::range(0, 0).chunks(3).map(&slice_to_vector<int>), std::vector<std::vector<int>>{ }), "chunks, empty iterator");
+
+    bool pointsIntoVector = true;
+    size_t offset = 0;
+    rusty::iter(numbers).chunks(4).for_each([&](const rusty::Slice<int>& chunk)
+    {
+        pointsIntoVector &= chunk.data() == numbers.data() + offset;
+        offset += chunk.size();
+    });
+
+    testCase(pointsIntoVector && offset == numbers.size(), "chunks, contiguous source is not copied");
+
+    testCase(test_iter(
+        rusty::iter(numbers).chunks_exact(3).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 } }
+    ), "chunks_exact, from vector");
+
+    testCase(test_iter(
+        rusty::range(0, 10).chunks_exact(3).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 } }
+    ), "chunks_exact, from range");
+
+    auto exactIter = rusty::iter(numbers).chunks_exact(4);
+    bool remainderEmptyBefore = exactIter.remainder().empty();
+    exactIter.for_each([](const rusty::Slice<int>&) { });
+    testCase(remainderEmptyBefore && collections_equal(slice_to_vector(exactIter.remainder()), std::vector<int>{ 8, 9 }), "chunks_exact, remainder from vector");
+
+    auto exactRangeIter = rusty::range(0, 10).chunks_exact(4);
+    exactRangeIter.for_each([](const rusty::Slice<int>&) { });
+    testCase(collections_equal(slice_to_vector(exactRangeIter.remainder()), std::vector<int>{ 8, 9 }), "chunks_exact, remainder from range");
+
+    auto exactDivisibleIter = rusty::range(0, 10).chunks_exact(5);
+    testCase(exactDivisibleIter.count() == 2 && exactDivisibleIter.remainder().empty(), "chunks_exact, divisible, empty remainder");
+
+    testCase(rusty::iter(numbers)
+        .chunks(3)
+        .map([](const rusty::Slice<int>& chunk) { return rusty::iter(chunk).sum(); })
+        .collect<std::vector<int>>() == std::vector<int>{ 3, 12, 21, 9 }
+        , "chunks, iterating over the chunks"
+    );
+
+    const int constNumbers[] = { 1, 2, 3 };
+    static_assert(std::is_same_v<decltype(rusty::iter(std::begin(constNumbers), std::end(constNumbers)))::OutType, int>, "iterators over const elements yield non-const values");
+    static_assert(std::is_same_v<decltype(rusty::iter(rusty::Slice<int>()))::OutType, int>, "iterators over slices yield non-const values");
+    testCase(rusty::iter(std::begin(constNumbers), std::end(constNumbers)).sum() == 6
+        && rusty::iter(std::begin(constNumbers), std::end(constNumbers)).max() == 3, "iterators over const elements, aggregates");
+}
+
+void test_windows(TestCase& testCase)
+{
+    std::vector<int> numbers = { 0, 1, 2, 3, 4, 5 };
+
+    testCase(test_iter(
+        rusty::iter(numbers).windows(3).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2 }, { 1, 2, 3 }, { 2, 3, 4 }, { 3, 4, 5 } }
+    ), "windows, from vector");
+
+    testCase(test_iter(
+        rusty::range(0, 6).windows(3).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2 }, { 1, 2, 3 }, { 2, 3, 4 }, { 3, 4, 5 } }
+    ), "windows, from range");
+
+    testCase(test_iter(
+        rusty::range(0, 4).windows(1).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0 }, { 1 }, { 2 }, { 3 } }
+    ), "windows, size 1");
+
+    testCase(test_iter(
+        rusty::range(0, 3).windows(3).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2 } }
+    ), "windows, same size as the iterator");
+
+    testCase(test_iter(rusty::range(0, 2).windows(3).map(&slice_to_vector<int>), std::vector<std::vector<int>>{ }), "windows, iterator too short");
+    testCase(test_iter(rusty::iter(numbers).windows(10).map(&slice_to_vector<int>), std::vector<std::vector<int>>{ }), "windows, vector too short");
+    testCase(test_iter(rusty::range(0, 10).windows(0).map(&slice_to_vector<int>), std::vector<std::vector<int>>{ }), "windows, size 0");
+
+    bool pointsIntoVector = true;
+    size_t offset = 0;
+    rusty::iter(numbers).windows(2).for_each([&](const rusty::Slice<int>& window)
+    {
+        pointsIntoVector &= window.data() == numbers.data() + offset;
+        ++offset;
+    });
+
+    testCase(pointsIntoVector && offset == 5, "windows, contiguous source is not copied");
+}
+
+void test_rolling(TestCase& testCase)
+{
+    std::vector<int> numbers = { 4, 2, 12, 3, 8, 8, 1, 5 };
+    testCase(test_iter(rusty::iter(numbers).rolling_sum(3), std::vector<int>{ 18, 17, 23, 19, 17, 14 }), "rolling_sum, from vector");
+    testCase(test_iter(rusty::iter(numbers).rolling_sum(8), std::vector<int>{ 43 }), "rolling_sum, window size equals length");
+    testCase(test_iter(rusty::iter(numbers).rolling_sum(9), std::vector<int>{ }), "rolling_sum, window larger than length");
+    testCase(test_iter(rusty::iter(numbers).rolling_sum(0), std::vector<int>{ }), "rolling_sum, window size 0");
+    testCase(test_iter(rusty::iter(numbers).rolling_sum<long long>(1), std::vector<long long>{ 4, 2, 12, 3, 8, 8, 1, 5 }), "rolling_sum, window size 1");
+    testCase(test_iter(rusty::iter(numbers).rolling_mean(4), std::vector<double>{ 5.25, 6.25, 7.75, 5.0, 5.5 }), "rolling_mean, from vector");
+
+    std::vector<double> fractions = rusty::range(0, 10000).map([](const int& num) { return 0.1 * (num % 7); }).collect<std::vector<double>>();
+    double lastSum = *rusty::iter(fractions).rolling_sum(10).last();
+    double expectedSum = rusty::iter(fractions).skip(9990).sum();
+    testCase(std::abs(lastSum - expectedSum) < 1e-12, "rolling_sum, floating point errors don't accumulate");
+
+    testCase(test_iter(rusty::iter(numbers).rolling_min(3), std::vector<int>{ 2, 2, 3, 3, 1, 1 }), "rolling_min, from vector");
+    testCase(test_iter(rusty::iter(numbers).rolling_max(3), std::vector<int>{ 12, 12, 12, 8, 8, 8 }), "rolling_max, from vector");
+    testCase(test_iter(rusty::iter(numbers).rolling_min(1), numbers), "rolling_min, window size 1");
+    testCase(test_iter(rusty::iter(numbers).rolling_max(0), std::vector<int>{ }), "rolling_max, window size 0");
+    testCase(test_iter(rusty::range(0, 5).rolling_min(2), std::vector<int>{ 0, 1, 2, 3 }), "rolling_min, increasing");
+    testCase(test_iter(rusty::range(0, 5).reverse().rolling_min(2), std::vector<int>{ 3, 2, 1, 0 }), "rolling_min, decreasing");
+
+    std::vector<int> many = rusty::range(0, 500).map([](const int& num) { return (num * 7919) % 97; }).collect<std::vector<int>>();
+    bool sameAsWindows = true;
+    for (size_t windowSize : { 1, 2, 5, 17, 64 })
+    {
+        std::vector<int> expectedMin = rusty::iter(many).windows(windowSize).map([](const rusty::Slice<int>& window) { return *rusty::iter(window).min(); }).collect<std::vector<int>>();
+        std::vector<int> expectedMax = rusty::iter(many).windows(windowSize).map([](const rusty::Slice<int>& window) { return *rusty::iter(window).max(); }).collect<std::vector<int>>();
+        sameAsWindows = sameAsWindows && test_iter(rusty::iter(many).rolling_min(windowSize), expectedMin) && test_iter(rusty::iter(many).rolling_max(windowSize), expectedMax);
+    }
+
+    testCase(sameAsWindows, "rolling_min and rolling_max, same as windows");
+}
+
+void test_array_chunks(TestCase& testCase)
+{
+    std::vector<int> numbers = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+    testCase(test_iter(
+        rusty::iter(numbers).array_chunks<4>(),
+        std::vector<std::array<int, 4>>{ { 0, 1, 2, 3 }, { 4, 5, 6, 7 } }
+    ), "array_chunks, from vector");
+
+    testCase(test_iter(
+        rusty::range(0, 10).array_chunks<3>(),
+        std::vector<std::array<int, 3>>{ { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 } }
+    ), "array_chunks, from range");
+
+    testCase(test_iter(rusty::range(0, 3).array_chunks<4>(), std::vector<std::array<int, 4>>{ }), "array_chunks, iterator too short");
+
+    auto vectorIter = rusty::iter(numbers).array_chunks<4>();
+    bool remainderEmptyBefore = vectorIter.remainder().empty();
+    testCase(vectorIter.count() == 2 && remainderEmptyBefore && collections_equal(slice_to_vector(vectorIter.remainder()), std::vector<int>{ 8, 9 }), "array_chunks, remainder from vector");
+
+    auto rangeIter = rusty::range(0, 10).array_chunks<4>();
+    testCase(rangeIter.count() == 2 && collections_equal(slice_to_vector(rangeIter.remainder()), std::vector<int>{ 8, 9 }), "array_chunks, remainder from range");
+
+    auto divisibleIter = rusty::range(0, 10).array_chunks<5>();
+    testCase(divisibleIter.count() == 2 && divisibleIter.remainder().empty(), "array_chunks, divisible, empty remainder");
+
+    testCase(rusty::range(0, 8)
+        .array_chunks<4>()
+        .map([](const std::array<int, 4>& chunk) { return chunk[0] + chunk[1] + chunk[2] + chunk[3]; })
+        .collect<std::vector<int>>() == std::vector<int>{ 6, 22 }
+        , "array_chunks, summing the chunks"
+    );
+}
+
+void test_chunk_by(TestCase& testCase)
+{
+    std::vector<int> numbers = { 1, 1, 2, 3, 3, 3, 1, 4, 4 };
+    auto identity = [](const int& num) { return num; };
+
+    testCase(test_iter(
+        rusty::iter(numbers).chunk_by(identity).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 1, 1 }, { 2 }, { 3, 3, 3 }, { 1 }, { 4, 4 } }
+    ), "chunk_by, from vector");
+
+    testCase(test_iter(
+        rusty::iter(numbers).map(identity).chunk_by(identity).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 1, 1 }, { 2 }, { 3, 3, 3 }, { 1 }, { 4, 4 } }
+    ), "chunk_by, non-contiguous");
+
+    testCase(test_iter(
+        rusty::range(0, 10).chunk_by([](const int& num) { return num / 4; }).map(&slice_to_vector<int>),
+        std::vector<std::vector<int>>{ { 0, 1, 2, 3 }, { 4, 5, 6, 7 }, { 8, 9 } }
+    ), "chunk_by, key function");
+
+    std::vector<std::string> texts = { "apple", "avocado", "banana", "blueberry", "cherry" };
+    testCase(test_iter(
+        rusty::iter(texts)
+            .chunk_by([](const std::string& str) { return str[0]; })
+            .map([](const rusty::Slice<std::string>& group) { return group.size(); }),
+        std::vector<size_t>{ 2, 2, 1 }
+    ), "chunk_by, strings grouped by first letter");
+
+    testCase(test_iter(rusty::range(0, 0).chunk_by(identity).map(&slice_to_vector<int>), std::vector<std::vector<int>>{ }), "chunk_by, empty iterator");
+    testCase(test_iter(rusty::once(5).chunk_by(identity).map(&slice_to_vector<int>), std::vector<std::vector<int>>{ { 5 } }), "chunk_by, single element");
+
+    size_t keyCalls = 0;
+    rusty::iter(numbers).chunk_by([&](const int& num) { ++keyCalls; return num; }).for_each([](const rusty::Slice<int>&) { });
+    testCase(keyCalls == numbers.size(), "chunk_by, key function is called once per element");
+}
+
+void test_dedup(TestCase& testCase)
+{
+    std::vector<int> numbers = { 1, 1, 2, 3, 3, 3, 1, 4, 4 };
+    std::vector<int> expected = { 1, 2, 3, 1, 4 };
+    auto identity = [](const int& num) { return num; };
+
+    testCase(test_iter(rusty::iter(numbers).dedup(), expected), "dedup, from vector");
+    testCase(test_iter(rusty::iter(numbers).map(identity).dedup(), expected), "dedup, non-stable pointers");
+    testCase(test_iter(rusty::range(0, 0).dedup(), std::vector<int>{ }), "dedup, empty iterator");
+    testCase(test_iter(rusty::repeat(7).take(5).dedup(), std::vector<int>{ 7 }), "dedup, all elements equal");
+
+    testCase(test_iter(rusty::iter(numbers).dedup().reverse(), std::vector<int>{ 4, 1, 3, 2, 1 }), "dedup, reversed");
+
+    testCase(test_iter(
+        rusty::range(0, 10).dedup_by([](const int& a, const int& b) { return a / 3 == b / 3; }),
+        std::vector<int>{ 0, 3, 6, 9 }
+    ), "dedup_by");
+
+    testCase(test_iter(
+        rusty::range(0, 10).dedup_by_key([](const int& num) { return num / 4; }),
+        std::vector<int>{ 0, 4, 8 }
+    ), "dedup_by_key");
+
+    testCase(test_iter(
+        rusty::range(0, 10).dedup_by_key([](const int& num) { return num / 4; }).reverse(),
+        std::vector<int>{ 8, 4, 0 }
+    ), "dedup_by_key, reversed yields the first element of each run");
+
+    size_t keyCalls = 0;
+    auto countedKey = [&](const int& num) { ++keyCalls; return num / 4; };
+    size_t dedupCount = rusty::range(0, 10).dedup_by_key(countedKey).count();
+    testCase(dedupCount == 3 && keyCalls == 10, "dedup_by_key, the key function is called once per element");
+
+    keyCalls = 0;
+    size_t reversedCount = rusty::range(0, 10).dedup_by_key(countedKey).reverse().count();
+    testCase(reversedCount == 3 && keyCalls == 10, "dedup_by_key, reversed, the key function is called once per element");
+
+    auto mixedIter = rusty::iter(numbers).dedup();
+    std::vector<int> mixedResult;
+    mixedResult.push_back(*mixedIter.next());
+    mixedResult.push_back(*mixedIter.next_back());
+    mixedResult.push_back(*mixedIter.next());
+    mixedResult.push_back(*mixedIter.next_back());
+    mixedResult.push_back(*mixedIter.next());
+    bool mixedDone = mixedIter.next() == nullptr && mixedIter.next_back() == nullptr;
+    testCase(mixedDone && collections_equal(mixedResult, std::vector<int>{ 1, 4, 2, 1, 3 }), "dedup, iterating from both ends");
+
+    std::vector<int> sameValues = { 5, 5, 5, 5 };
+    auto sameIter = rusty::iter(sameValues).dedup();
+    bool sameOk = *sameIter.next() == 5 && sameIter.next_back() == nullptr && sameIter.next() == nullptr;
+    testCase(sameOk, "dedup, run shared between the front and the back is only yielded once");
+
+    std::vector<int> seamValues = { 1, 2, 2, 2, 3 };
+    auto seamDedup = rusty::iter(seamValues).dedup();
+    std::vector<int> seamResult;
+    seamResult.push_back(*seamDedup.next_back());
+    seamResult.push_back(*seamDedup.next());
+    seamResult.push_back(*seamDedup.next());
+    bool seamDone = seamDedup.next_back() == nullptr && seamDedup.next() == nullptr;
+    testCase(seamDone && collections_equal(seamResult, std::vector<int>{ 3, 1, 2 }), "dedup, run split between the front and the back");
+}
+
+void test_unique(TestCase& testCase)
+{
+    std::vector<int> numbers = { 3, 1, 3, 2, 1, 5, 2, 4, 3 };
+
+    testCase(test_iter(rusty::iter(numbers).unique(), std::vector<int>{ 3, 1, 2, 5, 4 }), "unique, from vector");
+    testCase(test_iter(rusty::range(0, 0).unique(), std::vector<int>{ }), "unique, empty iterator");
+    testCase(test_iter(rusty::range(0, 100).map([](const int& num) { return num % 7; }).unique(), std::vector<int>{ 0, 1, 2, 3, 4, 5, 6 }), "unique, many duplicates");
+    testCase(rusty::range(0, 10000).unique().count() == 10000, "unique, many distinct values");
+
+    std::vector<std::string> texts = { "apple", "banana", "avocado", "cherry", "blueberry" };
+    testCase(test_iter(
+        rusty::iter(texts).unique_by([](const std::string& str) { return str[0]; }),
+        std::vector<std::string>{ "apple", "banana", "cherry" }
+    ), "unique_by, first letter");
+
+    testCase(test_iter(rusty::iter(numbers).unique_bounded(16), std::vector<int>{ 3, 1, 2, 5, 4 }), "unique_bounded, enough capacity");
+
+    // with a small capacity, duplicates may be yielded, but all distinct values are always yielded
+    std::vector<int> boundedResult = rusty::range(0, 1000)
+        .map([](const int& num) { return num % 100; })
+        .unique_bounded(4)
+        .collect<std::vector<int>>();
+
+    testCase(boundedResult.size() >= 100 && boundedResult.size() <= 1000 && rusty::range(0, 100).all([&](const int& num)
+    {
+        return rusty::iter(boundedResult).any([&](const int& value) { return value == num; });
+    }), "unique_bounded, small capacity");
+
+    testCase(test_iter(
+        rusty::range(0, 20).unique_by_bounded([](const int& num) { return num % 3; }, 8),
+        std::vector<int>{ 0, 1, 2 }
+    ), "unique_by_bounded");
+}
+
+void test_map_while(TestCase& testCase)
+{
+    std::vector<std::string> texts = { "1", "2", "3", "x", "4" };
+    auto parse = [](const std::string& str) -> std::optional<int>
+    {
+        if (str.empty() || str[0] < '0' || str[0] > '9')
+        {
+            return { };
+        }
+
+        return std::stoi(str);
+    };
+
+    testCase(test_iter(rusty::iter(texts).map_while(parse), std::vector<int>{ 1, 2, 3 }), "map_while, stops at the first empty value");
+    testCase(test_iter(rusty::range(0, 5).map_while([](const int& num) -> std::optional<int> { return num * 2; }), std::vector<int>{ 0, 2, 4, 6, 8 }), "map_while, never stops");
+    testCase(test_iter(rusty::range(0, 0).map_while([](const int& num) -> std::optional<int> { return num; }), std::vector<int>{ }), "map_while, empty iterator");
+
+    int callCount = 0;
+    auto countingIter = rusty::iter(texts).map_while([&](const std::string& str) { ++callCount; return parse(str); });
+    countingIter.for_each([](const int&) { });
+    bool stillDone = countingIter.next() == nullptr;
+    testCase(callCount == 4 && stillDone, "map_while, function is called once per element, and not after stopping");
+}
+
+// Iterator which is not fused, yields 1, 2, then null, then 4, 5, then null, etc.
+struct NonFusedIter : public rusty::Iterator<NonFusedIter, int>
+{
+    using OutType = int;
+
+    const int* next_impl()
+    {
+        ++_value;
+        return _value % 3 == 0 ? nullptr : &_value;
+    }
+
+    int _value = 0;
+};
+
+void test_fuse(TestCase& testCase)
+{
+    auto nonFusedIter = NonFusedIter();
+    bool nonFusedOk = *nonFusedIter.next() == 1 && *nonFusedIter.next() == 2 && nonFusedIter.next() == nullptr && *nonFusedIter.next() == 4;
+    testCase(nonFusedOk, "fuse, non-fused iterator test setup");
+
+    auto fusedIter = NonFusedIter().fuse();
+    bool fusedOk = *fusedIter.next() == 1 && *fusedIter.next() == 2 && fusedIter.next() == nullptr && fusedIter.next() == nullptr && fusedIter.next() == nullptr;
+    testCase(fusedOk, "fuse, non-fused iterator");
+
+    testCase(test_iter(rusty::range(0, 5).fuse().reverse(), std::vector<int>{ 4, 3, 2, 1, 0 }), "fuse, double-ended");
+
+    std::vector<int> numbers = { 1, 2, 3 };
+    static_assert(std::is_same_v<decltype(rusty::iter(numbers).fuse()), decltype(rusty::iter(numbers))>, "fuse on a collection iterator returns the same iterator type");
+    static_assert(std::is_same_v<decltype(rusty::range(0, 3).fuse()), decltype(rusty::range(0, 3))>, "fuse on a range returns the same iterator type");
+    static_assert(!std::is_same_v<decltype(NonFusedIter().fuse()), NonFusedIter>, "fuse on a non-fused iterator returns a new iterator type");
+
+    testCase(test_iter(rusty::iter(numbers).fuse(), numbers), "fuse, from vector");
+}
+
+template <typename T>
+std::vector<T> references_to_vector(const std::vector<std::reference_wrapper<const T>>& references)
+{
+    return std::vector<T>(references.begin(), references.end());
+}
+
+void test_combinatorics(TestCase& testCase)
+{
+    std::vector<int> numbers = { 1, 2, 3 };
+    std::vector<std::string> letters = { "a", "b" };
+
+    auto toPair = [](const std::pair<const int&, const std::string&>& pair) { return std::to_string(pair.first) + pair.second; };
+    testCase(test_iter(rusty::iter(numbers).cartesian_product(rusty::iter(letters)).map(toPair), std::vector<std::string>{ "1a", "1b", "2a", "2b", "3a", "3b" }), "cartesian_product, from vectors");
+    testCase(rusty::iter(numbers).cartesian_product(rusty::range(0, 0)).count() == 0 && rusty::range(0, 0).cartesian_product(rusty::iter(letters)).count() == 0, "cartesian_product, empty side");
+
+    auto product = rusty::iter(numbers).cartesian_product(rusty::range(0, 4));
+    testCase(product.len() == 12, "cartesian_product, len");
+    product.next();
+    product.next();
+    testCase(product.len() == 10 && product.count() == 10, "cartesian_product, len after advancing");
+
+    const int* firstNumber = &numbers[0];
+    testCase(&rusty::iter(numbers).cartesian_product(rusty::iter(letters)).next()->first == firstNumber, "cartesian_product, yields references");
+
+    auto startedProduct = rusty::iter(numbers).map([](const int& num) { return num * 10; }).cartesian_product(rusty::iter(letters));
+    startedProduct.next();
+    auto productCopy = startedProduct;
+    startedProduct.for_each([](const std::pair<const int&, const std::string&>&) { });
+    testCase(test_iter(productCopy.map(toPair), std::vector<std::string>{ "10b", "20a", "20b", "30a", "30b" }), "cartesian_product, copying a started iterator");
+
+    auto combinations = rusty::range(0, 4).combinations(2).map(&references_to_vector<int>);
+    testCase(test_iter(combinations, std::vector<std::vector<int>>{ { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 }, { 2, 3 } }), "combinations, from range");
+    testCase(test_iter(rusty::iter(numbers).combinations(3).map(&references_to_vector<int>), std::vector<std::vector<int>>{ { 1, 2, 3 } }), "combinations, k equals length");
+    testCase(test_iter(rusty::iter(numbers).combinations(0).map(&references_to_vector<int>), std::vector<std::vector<int>>{ { } }), "combinations, k is 0");
+    testCase(rusty::iter(numbers).combinations(4).count() == 0, "combinations, k greater than length");
+    auto manyCombinations = rusty::range(0, 10).combinations(3);
+    testCase(manyCombinations.len() == 120 && manyCombinations.count() == 120, "combinations, len");
+
+    auto permutations = rusty::iter(numbers).permutations(2).map(&references_to_vector<int>);
+    testCase(test_iter(permutations, std::vector<std::vector<int>>{ { 1, 2 }, { 1, 3 }, { 2, 1 }, { 2, 3 }, { 3, 1 }, { 3, 2 } }), "permutations, k is 2");
+    auto fullPermutations = rusty::iter(numbers).permutations(3).map(&references_to_vector<int>);
+    testCase(test_iter(fullPermutations, std::vector<std::vector<int>>{ { 1, 2, 3 }, { 1, 3, 2 }, { 2, 1, 3 }, { 2, 3, 1 }, { 3, 1, 2 }, { 3, 2, 1 } }), "permutations, k equals length");
+    testCase(test_iter(rusty::iter(numbers).permutations(0).map(&references_to_vector<int>), std::vector<std::vector<int>>{ { } }), "permutations, k is 0");
+    testCase(rusty::iter(numbers).permutations(4).count() == 0, "permutations, k greater than length");
+
+    auto manyPermutations = rusty::range(0, 6).permutations(4);
+    testCase(manyPermutations.len() == 360, "permutations, len");
+    std::vector<std::vector<int>> allPermutations = manyPermutations.map(&references_to_vector<int>).collect<std::vector<std::vector<int>>>();
+    std::vector<std::vector<int>> sortedPermutations = allPermutations;
+    std::sort(sortedPermutations.begin(), sortedPermutations.end());
+    bool allDistinct = std::adjacent_find(sortedPermutations.begin(), sortedPermutations.end()) == sortedPermutations.end();
+    testCase(allPermutations.size() == 360 && allPermutations == sortedPermutations && allDistinct, "permutations, lexicographic order and distinct");
+
+    // 66! / 0! is 0 modulo 2^64, and the intermediate results of 66 choose 33 overflow even though the result fits
+    constexpr size_t maxSize = std::numeric_limits<size_t>::max();
+    auto hugePermutations = rusty::range(0, 66).permutations(66);
+    testCase(hugePermutations.len() == maxSize, "permutations, len saturates");
+    testCase(hugePermutations.take(3).count() == 3 && hugePermutations.len() == maxSize, "permutations, count overflows size_t");
+    auto hugeCombinations = rusty::range(0, 66).combinations(33);
+    testCase(hugeCombinations.len() == 7219428434016265740ull && hugeCombinations.take(3).count() == 3, "combinations, len with overflowing intermediate results");
+    testCase(rusty::range(0, 100).combinations(50).len() == maxSize && rusty::range(0, 100).combinations(50).take(2).count() == 2, "combinations, len saturates");
+    testCase(rusty::range(0, 100).combinations(99).len() == 100 && rusty::range(0, 100).combinations(99).count() == 100, "combinations, k close to length");
+}
+
+void test_tee(TestCase& testCase)
+{
+    auto [first, second] = rusty::range(0, 5).tee();
+    testCase(test_iter(first, std::vector<int>{ 0, 1, 2, 3, 4 }) && test_iter(second, std::vector<int>{ 0, 1, 2, 3, 4 }), "tee, two iterators");
+
+    size_t upstreamCalls = 0;
+    auto parsed = rusty::range(0, 100).map([&](const int& num) { ++upstreamCalls; return num * 2; });
+    auto [sumIter, maxIter, countIter] = parsed.tee<3>();
+    int sum = sumIter.sum();
+    std::optional<int> max = maxIter.max();
+    size_t count = countIter.count();
+    testCase(sum == 9900 && max == 198 && count == 100, "tee, three aggregates");
+    testCase(upstreamCalls == 100, "tee, upstream is only run once");
+
+    std::vector<std::string> strings = { "a", "b", "c" };
+    auto interleaved = rusty::iter(strings).map([](const std::string& str) { return str + "!"; }).tee<2>();
+    const std::string* a1 = interleaved[0].next();
+    const std::string* a2 = interleaved[1].next();
+    const std::string* b1 = interleaved[0].next();
+    testCase(*a1 == "a!" && *a2 == "a!" && *b1 == "b!", "tee, values stay valid until advanced");
+    const std::string* b2 = interleaved[1].next();
+    const std::string* c2 = interleaved[1].next();
+    const std::string* c1 = interleaved[0].next();
+    testCase(*b2 == "b!" && *c2 == "c!" && *c1 == "c!", "tee, lagging iterator catches up");
+    testCase(interleaved[0].next() == nullptr && interleaved[1].next() == nullptr, "tee, both finished");
+
+    testCase(test_iter(rusty::range(0, 0).tee<2>()[0], std::vector<int>{ }), "tee, empty iterator");
+    testCase(test_iter(rusty::range(0, 3).tee<1>()[0], std::vector<int>{ 0, 1, 2 }), "tee, one iterator");
+    testCase(test_iter(rusty::range(0, 6).tee()[1].filter([](const int& num) { return num % 2 == 0; }), std::vector<int>{ 0, 2, 4 }), "tee, used as an adapter");
+}
+
+void test_merge(TestCase& testCase)
+{
+    std::vector<int> evens = { 0, 2, 4, 6, 8 };
+    std::vector<int> odds = { 1, 3, 5, 7, 9, 11, 13 };
+
+    testCase(test_iter(rusty::iter(evens).merge(rusty::iter(odds)), std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 11, 13 }), "merge, two vectors");
+    testCase(test_iter(rusty::merge(rusty::iter(odds), rusty::range(0, 10, 4)), std::vector<int>{ 0, 1, 3, 4, 5, 7, 8, 9, 11, 13 }), "merge, free function, different iterator types");
+    testCase(test_iter(rusty::iter(evens).merge(rusty::empty<int>()), evens), "merge, second iterator is empty");
+    testCase(test_iter(rusty::empty<int>().merge(rusty::iter(evens)), evens), "merge, first iterator is empty");
+
+    std::vector<std::pair<int, char>> first = { { 1, 'a' }, { 2, 'a' } };
+    std::vector<std::pair<int, char>> second = { { 1, 'b' }, { 2, 'b' } };
+    auto compareFirst = [](const std::pair<int, char>& a, const std::pair<int, char>& b) { return a.first - b.first; };
+    testCase(test_iter(
+        rusty::iter(first).merge_by(rusty::iter(second), compareFirst),
+        std::vector<std::pair<int, char>>{ { 1, 'a' }, { 1, 'b' }, { 2, 'a' }, { 2, 'b' } }
+    ), "merge_by, stable");
+
+    testCase(test_iter(
+        rusty::merge_by(rusty::range(0, 5).reverse(), rusty::range(2, 4).reverse(), [](const int& a, const int& b) { return b - a; }),
+        std::vector<int>{ 4, 3, 3, 2, 2, 1, 0 }
+    ), "merge_by, descending");
+
+    std::vector<std::vector<int>> runs = { { 5, 10, 15 }, { }, { 1, 2, 3, 20 }, { 4, 5, 6 }, { 0 } };
+    std::vector<decltype(rusty::iter(runs[0]))> runIters;
+    for (const std::vector<int>& run : runs)
+    {
+        runIters.push_back(rusty::iter(run));
+    }
+
+    testCase(test_iter(rusty::kmerge(runIters), std::vector<int>{ 0, 1, 2, 3, 4, 5, 5, 6, 10, 15, 20 }), "kmerge, five iterators");
+    testCase(test_iter(rusty::kmerge(std::vector<decltype(rusty::iter(runs[0]))>{ }), std::vector<int>{ }), "kmerge, no iterators");
+    testCase(test_iter(rusty::kmerge(std::vector<decltype(rusty::iter(runs[0]))>{ rusty::iter(runs[2]) }), runs[2]), "kmerge, one iterator");
+
+    std::vector<decltype(rusty::range(0, 1))> rangeIters;
+    for (int i = 0; i < 13; ++i)
+    {
+        rangeIters.push_back(rusty::range(i, 100, 13));
+    }
+
+    testCase(test_iter(rusty::kmerge(rangeIters), rusty::range(0, 100).collect<std::vector<int>>()), "kmerge, 13 ranges");
+
+    std::vector<decltype(rusty::iter(first))> pairIters = { rusty::iter(second), rusty::iter(first) };
+    testCase(test_iter(
+        rusty::kmerge_by(pairIters, compareFirst),
+        std::vector<std::pair<int, char>>{ { 1, 'b' }, { 1, 'a' }, { 2, 'b' }, { 2, 'a' } }
+    ), "kmerge_by, stable");
+
+    // the current values of a started merge must not point into the original iterator after copying it
+    auto square = [](const int& num) { return num * num; };
+    auto startedMerge = rusty::iter(evens).map(square).merge(rusty::iter(odds).map(square));
+    startedMerge.next();
+    auto mergeCopy = startedMerge;
+    startedMerge.for_each([](const int&) { });
+    testCase(test_iter(mergeCopy, std::vector<int>{ 1, 4, 9, 16, 25, 36, 49, 64, 81, 121, 169 }), "merge, copying a started iterator");
+
+    std::vector<decltype(rusty::iter(runs[0]).map(square))> mappedRunIters;
+    for (const std::vector<int>& run : runs)
+    {
+        mappedRunIters.push_back(rusty::iter(run).map(square));
+    }
+
+    auto startedKMerge = rusty::kmerge(mappedRunIters);
+    startedKMerge.next();
+    auto kmergeCopy = startedKMerge;
+    startedKMerge.for_each([](const int&) { });
+    testCase(test_iter(kmergeCopy, std::vector<int>{ 1, 4, 9, 16, 25, 25, 36, 100, 225, 400 }), "kmerge, copying a started iterator");
+}
+
+void test_interleave(TestCase& testCase)
+{
+    testCase(test_iter(rusty::range(0, 3).interleave(rusty::range(10, 13)), std::vector<int>{ 0, 10, 1, 11, 2, 12 }), "interleave, same length");
+    testCase(test_iter(rusty::range(0, 5).interleave(rusty::range(10, 12)), std::vector<int>{ 0, 10, 1, 11, 2, 3, 4 }), "interleave, other is shorter");
+    testCase(test_iter(rusty::range(0, 2).interleave(rusty::range(10, 15)), std::vector<int>{ 0, 10, 1, 11, 12, 13, 14 }), "interleave, current is shorter");
+    testCase(test_iter(rusty::range(0, 0).interleave(rusty::range(10, 12)), std::vector<int>{ 10, 11 }), "interleave, current is empty");
+
+    std::vector<int> numbers = { 20, 21 };
+    testCase(test_iter(rusty::range(0, 3).interleave(rusty::iter(numbers)), std::vector<int>{ 0, 20, 1, 21, 2 }), "interleave, different iterator types");
+
+    NonFusedIter nonFused;
+    testCase(test_iter(nonFused.interleave(rusty::range(10, 16)), std::vector<int>{ 1, 10, 2, 11, 12, 13, 14, 15 }), "interleave, finished iterators are not advanced again");
+
+    std::vector<std::vector<int>> queues = { { 1, 2, 3, 4 }, { 10 }, { }, { 20, 21, 22 } };
+    std::vector<decltype(rusty::iter(queues[0]))> queueIters = rusty::iter(queues).map([](const std::vector<int>& queue) { return rusty::iter(queue); }).collect<std::vector<decltype(rusty::iter(queues[0]))>>();
+    testCase(test_iter(rusty::round_robin(queueIters), std::vector<int>{ 1, 10, 20, 2, 21, 3, 22, 4 }), "round_robin, from vector");
+    testCase(test_iter(rusty::round_robin({ rusty::range(0, 2), rusty::range(10, 13), rusty::range(20, 21) }), std::vector<int>{ 0, 10, 20, 1, 11, 12 }), "round_robin, from list");
+    testCase(test_iter(rusty::round_robin(std::vector<decltype(rusty::range(0, 1))>{ }), std::vector<int>{ }), "round_robin, no iterators");
+    testCase(test_iter(rusty::round_robin({ rusty::range(0, 3) }), std::vector<int>{ 0, 1, 2 }), "round_robin, one iterator");
+
+    size_t calls = 0;
+    auto counted = [&](int start, int end) { return rusty::range(start, end).inspect([&](const int&) { ++calls; }); };
+    rusty::round_robin({ counted(0, 1), counted(0, 50) }).count();
+    testCase(calls == 51, "round_robin, finished iterators are dropped");
+}
+
+void test_join(TestCase& testCase)
+{
+    struct User
+    {
+        int id;
+        std::string name;
+    };
+
+    struct Event
+    {
+        int userId;
+        std::string action;
+    };
+
+    std::vector<User> users = { { 1, "ann" }, { 2, "bob" }, { 3, "cid" } };
+    std::vector<Event> events = { { 2, "login" }, { 4, "login" }, { 1, "click" }, { 2, "logout" } };
+
+    auto toNames = [](const std::pair<const Event&, const User&>& pair) { return pair.second.name + ":" + pair.first.action; };
+    auto eventKey = [](const Event& event) { return event.userId; };
+    auto userKey = [](const User& user) { return user.id; };
+
+    auto joined = rusty::iter(events).hash_join(rusty::iter(users), eventKey, userKey);
+    testCase(test_iter(joined.map(toNames), std::vector<std::string>{ "bob:login", "ann:click", "bob:logout" }), "hash_join, build from smaller side");
+
+    // the events are collected here, because there are less events, so the pairs are in the order of the users
+    std::vector<User> manyUsers = rusty::range(0, 100).map([](const int& id) { return User{ id, "user" + std::to_string(id) }; }).collect<std::vector<User>>();
+    auto joinedMany = rusty::iter(events).hash_join(rusty::iter(manyUsers), eventKey, userKey);
+    testCase(test_iter(joinedMany.map(toNames), std::vector<std::string>{ "user1:click", "user2:login", "user2:logout", "user4:login" }), "hash_join, build from current side");
+
+    const User* firstUser = &users[0];
+    bool referencesProbedSide = rusty::iter(users).hash_join(rusty::iter(events).filter([](const Event&) { return true; }), userKey, eventKey)
+        .any([&](const std::pair<const User&, const Event&>& pair) { return &pair.first == firstUser; });
+    testCase(referencesProbedSide, "hash_join, yields references");
+
+    testCase(rusty::iter(events).hash_join(rusty::range(0, 0), eventKey, [](const int& num) { return num; }).count() == 0, "hash_join, empty side");
+    testCase(rusty::range(0, 6).hash_join(rusty::range(0, 6), [](const int& num) { return num % 2; }, [](const int& num) { return num % 3; }).count() == 12, "hash_join, duplicate keys");
+
+    auto square = [](const int& num) { return num * num; };
+    auto identity = [](const int& num) { return num; };
+    auto toValues = [](const std::pair<const int&, const int&>& pair) { return std::make_pair(pair.first, pair.second); };
+    std::vector<int> buildSide = { 4, 4, 25 };
+    std::vector<int> probeSide = { 1, 2, 2, 4, 5, 7 };
+    auto startedHashJoin = rusty::iter(probeSide).map(square).hash_join(rusty::iter(buildSide), identity, identity);
+    startedHashJoin.next();
+    auto hashJoinCopy = startedHashJoin;
+    startedHashJoin.for_each([](const std::pair<const int&, const int&>&) { });
+    testCase(test_iter(hashJoinCopy.map(toValues), std::vector<std::pair<int, int>>{ { 4, 4 }, { 4, 4 }, { 4, 4 }, { 25, 25 } }), "hash_join, copying a started iterator");
+
+    std::vector<int> left = { 1, 2, 2, 4, 5, 7 };
+    std::vector<int> right = { 0, 2, 2, 3, 5, 5, 7, 8 };
+    auto toPair = [](const std::pair<const int&, const int&>& pair) { return std::make_pair(pair.first, pair.second); };
+    auto mergeJoined = rusty::iter(left).merge_join(rusty::iter(right), [](const int& a, const int& b) { return a - b; }).map(toPair);
+    testCase(test_iter(mergeJoined, std::vector<std::pair<int, int>>{ { 2, 2 }, { 2, 2 }, { 2, 2 }, { 2, 2 }, { 5, 5 }, { 5, 5 }, { 7, 7 } }), "merge_join, from vectors");
+
+    const int* firstRight = &right[1];
+    testCase(&rusty::iter(left).merge_join(rusty::iter(right), [](const int& a, const int& b) { return a - b; }).next()->second == firstRight, "merge_join, yields references");
+    testCase(rusty::iter(left).merge_join(rusty::range(0, 0), [](const int& a, const int& b) { return a - b; }).count() == 0, "merge_join, empty side");
+
+    auto lambdaIter = rusty::range(0, 10).map([](const int& num) { return num / 2; });
+    testCase(rusty::range(0, 5).merge_join(lambdaIter, [](const int& a, const int& b) { return a - b; }).count() == 10, "merge_join, other iterator contains a lambda");
+
+    size_t otherReads = 0;
+    auto countedRight = rusty::iter(right).map([](const int& num) { return num * 10; }).inspect([&](const int&) { ++otherReads; });
+    auto scaledJoined = rusty::iter(left).merge_join(countedRight, [](const int& a, const int& b) { return a * 10 - b; })
+        .map([](const std::pair<const int&, const int&>& pair) { return std::make_pair(pair.first, pair.second); });
+    testCase(test_iter(scaledJoined, std::vector<std::pair<int, int>>{ { 2, 20 }, { 2, 20 }, { 2, 20 }, { 2, 20 }, { 5, 50 }, { 5, 50 }, { 7, 70 } }), "merge_join, non-stable pointers");
+
+    // the run of 2s is read twice (for both 2s of the left side), every other element is only read once
+    testCase(otherReads == right.size() + 2, "merge_join, other iterator is advanced in place");
+
+    std::vector<int> squaredRight = { 0, 4, 4, 9, 25, 25, 49, 64 };
+    auto startedMergeJoin = rusty::iter(left).map(square).merge_join(rusty::iter(squaredRight).map(identity), [](const int& a, const int& b) { return a - b; });
+    startedMergeJoin.next();
+    auto mergeJoinCopy = startedMergeJoin;
+    startedMergeJoin.for_each([](const std::pair<const int&, const int&>&) { });
+    testCase(test_iter(mergeJoinCopy.map(toValues), std::vector<std::pair<int, int>>{ { 4, 4 }, { 4, 4 }, { 4, 4 }, { 25, 25 }, { 25, 25 }, { 49, 49 } }), "merge_join, copying a started iterator");
+}
+
+void test_set_operations(TestCase& testCase)
+{
+    std::vector<int> a = { 1, 2, 2, 2, 4, 6, 8, 9 };
+    std::vector<int> b = { 2, 2, 3, 4, 5, 9, 9, 10 };
+    testCase(test_iter(rusty::iter(a).intersect(rusty::iter(b)), std::vector<int>{ 2, 2, 4, 9 }), "intersect, from vectors");
+    testCase(test_iter(rusty::iter(a).union_sorted(rusty::iter(b)), std::vector<int>{ 1, 2, 2, 2, 3, 4, 5, 6, 8, 9, 9, 10 }), "union_sorted, from vectors");
+    testCase(test_iter(rusty::iter(a).difference(rusty::iter(b)), std::vector<int>{ 1, 2, 6, 8 }), "difference, from vectors");
+    testCase(test_iter(rusty::iter(a).sym_difference(rusty::iter(b)), std::vector<int>{ 1, 2, 3, 5, 6, 8, 9, 10 }), "sym_difference, from vectors");
+    testCase(test_iter(rusty::range(0, 10).intersect(rusty::iter(b)), std::vector<int>{ 2, 3, 4, 5, 9 }), "intersect, range and vector");
+    testCase(test_iter(rusty::iter(a).difference(rusty::range(0, 0)), a), "difference, empty other iterator");
+    testCase(test_iter(rusty::range(0, 0).union_sorted(rusty::iter(b)), b), "union_sorted, empty current iterator");
+
+    auto descending = [](const int& x, const int& y) { return y - x; };
+    testCase(test_iter(rusty::iter(a).reverse().intersect_by(rusty::iter(b).reverse(), descending), std::vector<int>{ 9, 4, 2, 2 }), "intersect_by, descending");
+    testCase(test_iter(rusty::iter(a).reverse().difference_by(rusty::iter(b).reverse(), descending), std::vector<int>{ 8, 6, 2, 1 }), "difference_by, descending");
+
+    // compare with the standard algorithms, with and without galloping
+    bool sameAsStd = true;
+    for (int seed = 1; seed < 30; ++seed)
+    {
+        std::vector<int> x = rusty::range(0, seed * 7).map([=](const int& num) { return (num * seed * 31) % 50; }).collect<std::vector<int>>();
+        std::vector<int> y = rusty::range(0, 100 - seed * 3).map([=](const int& num) { return (num * 17 + seed) % 70; }).collect<std::vector<int>>();
+        std::sort(x.begin(), x.end());
+        std::sort(y.begin(), y.end());
+        std::list<int> yList(y.begin(), y.end());
+
+        std::vector<int> expected;
+        std::set_intersection(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(expected));
+        sameAsStd = sameAsStd && test_iter(rusty::iter(x).intersect(rusty::iter(y)), expected) && test_iter(rusty::iter(x).intersect(rusty::iter(yList)), expected);
+
+        expected.clear();
+        std::set_union(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(expected));
+        sameAsStd = sameAsStd && test_iter(rusty::iter(x).union_sorted(rusty::iter(y)), expected);
+
+        expected.clear();
+        std::set_difference(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(expected));
+        sameAsStd = sameAsStd && test_iter(rusty::iter(x).difference(rusty::iter(y)), expected) && test_iter(rusty::iter(x).difference(rusty::iter(yList)), expected);
+
+        expected.clear();
+        std::set_symmetric_difference(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(expected));
+        sameAsStd = sameAsStd && test_iter(rusty::iter(x).sym_difference(rusty::iter(y)), expected);
+    }
+
+    testCase(sameAsStd, "set operations, same as the standard algorithms");
+
+    std::vector<int> small = { 100, 5000, 99999 };
+    std::vector<int> large = rusty::range(0, 100000).collect<std::vector<int>>();
+    size_t comparisons = 0;
+    auto countingComparer = [&](const int& x, const int& y) { ++comparisons; return x < y ? -1 : (x > y ? 1 : 0); };
+    testCase(test_iter(rusty::iter(small).intersect_by(rusty::iter(large), countingComparer), small), "intersect_by, small and large");
+    testCase(comparisons < 200, "intersect_by, galloping skips the large iterator");
+
+    auto square = [](const int& num) { return num * num; };
+    auto startedUnion = rusty::iter(a).map(square).union_sorted(rusty::iter(b).map(square));
+    startedUnion.next();
+    auto unionCopy = startedUnion;
+    startedUnion.for_each([](const int&) { });
+    testCase(test_iter(unionCopy, std::vector<int>{ 4, 4, 4, 9, 16, 25, 36, 64, 81, 81, 100 }), "union_sorted, copying a started iterator");
+}
+
+void test_sorted_lazy(TestCase& testCase)
+{
+    std::vector<int> numbers = { 5, 1, 9, 3, 7, 2, 8, 6, 4, 0 };
+    testCase(test_iter(rusty::iter(numbers).sorted_lazy(), std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }), "sorted_lazy, from vector");
+    testCase(test_iter(rusty::range(0, 0).sorted_lazy(), std::vector<int>{ }), "sorted_lazy, empty iterator");
+    testCase(test_iter(rusty::iter(numbers).sorted_lazy_by([](const int& a, const int& b) { return b - a; }), std::vector<int>{ 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 }), "sorted_lazy_by, descending");
+
+    std::vector<int> shuffled = rusty::range(0, 1000).map([](const int& num) { return (num * 379) % 1000; }).collect<std::vector<int>>();
+    testCase(test_iter(rusty::iter(shuffled).sorted_lazy(), rusty::range(0, 1000).collect<std::vector<int>>()), "sorted_lazy, many elements");
+    testCase(test_iter(rusty::iter(shuffled).sorted_lazy().take(5), std::vector<int>{ 0, 1, 2, 3, 4 }), "sorted_lazy, first few elements");
+
+    std::vector<int> duplicates = rusty::range(0, 500).map([](const int& num) { return (num * 7) % 3; }).collect<std::vector<int>>();
+    testCase(rusty::iter(duplicates).sorted_lazy().is_sorted_ascending() && rusty::iter(duplicates).sorted_lazy().count() == 500, "sorted_lazy, many duplicates");
+    testCase(rusty::repeat(4).take(300).sorted_lazy().count() == 300, "sorted_lazy, all elements equal");
+
+    size_t comparisons = 0;
+    rusty::iter(shuffled).sorted_lazy_by([&](const int& a, const int& b) { ++comparisons; return a - b; }).take(10).for_each([](const int&) { });
+    testCase(comparisons < 5000, "sorted_lazy_by, taking a few elements doesn't sort everything");
+
+    // McIlroy's adversary: the values are decided while sorting, so that every pivot is as bad as possible
+    constexpr int adversaryCount = 4000;
+    std::vector<int> adversaryValues(adversaryCount, adversaryCount);
+    int frozenCount = 0;
+    int candidate = 0;
+    comparisons = 0;
+    auto adversary = [&](const int& a, const int& b)
+    {
+        ++comparisons;
+        if (adversaryValues[a] == adversaryCount && adversaryValues[b] == adversaryCount)
+        {
+            adversaryValues[a == candidate ? a : b] = frozenCount++;
+        }
+
+        if (adversaryValues[a] == adversaryCount)
+        {
+            candidate = a;
+        }
+        else if (adversaryValues[b] == adversaryCount)
+        {
+            candidate = b;
+        }
+
+        return adversaryValues[a] - adversaryValues[b];
+    };
+
+    size_t adversaryResult = rusty::range(0, adversaryCount).sorted_lazy_by(adversary).count();
+    testCase(adversaryResult == adversaryCount && comparisons < 400000, "sorted_lazy_by, adversarial input is not quadratic");
+}
 
 void test_collect(TestCase& testCase)
 {
@@ -1139,6 +1888,117 @@ void test_position(TestCase& testCase)
     testCase(rusty::iter(numbers).rposition([](const int& number) { return number > 5; }) == 0, "rposition, find a number >5");
 }
 
+void test_binary_search(TestCase& testCase)
+{
+    std::vector<int> numbers = { 1, 3, 3, 3, 5, 8, 13, 21 };
+    std::list<int> numberList(numbers.begin(), numbers.end());
+    std::deque<int> numberDeque(numbers.begin(), numbers.end());
+
+    static_assert(rusty::is_random_access_v<decltype(rusty::iter(numbers))>, "vector iterators are random access");
+    static_assert(rusty::is_random_access_v<decltype(rusty::iter(numberDeque))>, "deque iterators are random access");
+    static_assert(!rusty::is_random_access_v<decltype(rusty::iter(numberList))>, "list iterators are not random access");
+
+    auto lessThan5 = [](const int& num) { return num < 5; };
+    testCase(rusty::iter(numbers).partition_point(lessThan5) == 4, "partition_point, contiguous");
+    testCase(rusty::iter(numberDeque).partition_point(lessThan5) == 4, "partition_point, random access");
+    testCase(rusty::iter(numberList).partition_point(lessThan5) == 4, "partition_point, linear");
+    testCase(rusty::iter(numbers).partition_point([](const int&) { return true; }) == 8, "partition_point, all true");
+    testCase(rusty::iter(numbers).partition_point([](const int&) { return false; }) == 0, "partition_point, all false");
+    testCase(rusty::range(0, 0).partition_point(lessThan5) == 0, "partition_point, empty iterator");
+
+    auto contiguousIter = rusty::iter(numbers);
+    auto dequeIter = rusty::iter(numberDeque);
+    auto listIter = rusty::iter(numberList);
+    contiguousIter.partition_point(lessThan5);
+    dequeIter.partition_point(lessThan5);
+    listIter.partition_point(lessThan5);
+    testCase(*contiguousIter.next() == 5 && *dequeIter.next() == 5, "partition_point, random access iterators are positioned at the partition point");
+    testCase(*listIter.next() == 8, "partition_point, linear iterators consume the partition point");
+
+    auto allTrueIter = rusty::iter(numberDeque);
+    allTrueIter.partition_point([](const int&) { return true; });
+    testCase(allTrueIter.next() == nullptr, "partition_point, all true, iterator finished");
+
+    auto searchedContiguous = rusty::iter(numbers);
+    auto searchedList = rusty::iter(numberList);
+    testCase(searchedContiguous.binary_search(3) == 1 && *searchedContiguous.next() == 3 && *searchedContiguous.next() == 3, "binary_search, random access iterators are positioned at the found element");
+    testCase(!searchedContiguous.binary_search(4).has_value() && *searchedContiguous.next() == 5, "binary_search, random access iterators are positioned at the first greater element");
+    testCase(searchedList.binary_search(3) == 1 && *searchedList.next() == 3 && *searchedList.next() == 3 && *searchedList.next() == 5, "binary_search, linear iterators consume the found element");
+    testCase(!searchedList.binary_search(4).has_value() && *searchedList.next() == 13, "binary_search, linear iterators consume the first greater element");
+
+    testCase(rusty::iter(numbers).binary_search(3) == 1 && rusty::iter(numberDeque).binary_search(3) == 1 && rusty::iter(numberList).binary_search(3) == 1, "binary_search, first equal element");
+    testCase(rusty::iter(numbers).binary_search(21) == 7 && rusty::iter(numbers).binary_search(1) == 0, "binary_search, first and last element");
+    testCase(!rusty::iter(numbers).binary_search(4).has_value() && !rusty::iter(numberList).binary_search(4).has_value(), "binary_search, missing element");
+    testCase(!rusty::iter(numbers).binary_search(30).has_value() && !rusty::iter(numbers).binary_search(0).has_value(), "binary_search, out of range");
+    testCase(rusty::iter(numbers).binary_search_by([](const int& num) { return num - 8; }) == 5, "binary_search_by");
+
+    std::vector<int> many = rusty::range(0, 1000).map([](const int& num) { return num * 2; }).collect<std::vector<int>>();
+    bool allFound = rusty::range(0, 2000).all([&](const int& num)
+    {
+        std::optional<size_t> index = rusty::iter(many).binary_search(num);
+        return num % 2 == 0 ? index == static_cast<size_t>(num / 2) : !index.has_value();
+    });
+
+    testCase(allFound, "binary_search, many elements");
+
+    size_t comparisons = 0;
+    rusty::iter(many).binary_search_by([&](const int& num) { ++comparisons; return num - 1234; });
+    testCase(comparisons <= 12, "binary_search_by, logarithmic number of comparisons");
+}
+
+void test_skip_until(TestCase& testCase)
+{
+    std::vector<int> numbers = { 1, 3, 3, 5, 8, 13, 21, 34 };
+    std::list<int> numberList(numbers.begin(), numbers.end());
+
+    auto it = rusty::iter(numbers);
+    testCase(*it.skip_until_ge(3) == 3 && *it.next() == 3, "skip_until_ge, stops at the first equal element");
+    testCase(*it.skip_until_ge(6) == 8 && *it.skip_until_ge(8) == 13 && *it.skip_until_ge(0) == 21, "skip_until_ge, repeated calls");
+    testCase(it.skip_until_ge(100) == nullptr && it.next() == nullptr, "skip_until_ge, past the end");
+
+    auto listIt = rusty::iter(numberList);
+    testCase(*listIt.skip_until_ge(4) == 5 && *listIt.skip_until_ge(21) == 21 && listIt.skip_until_ge(35) == nullptr, "skip_until_ge, linear");
+    testCase(rusty::range(0, 0).skip_until_ge(3) == nullptr, "skip_until_ge, empty iterator");
+
+    auto descending = rusty::iter(numbers).reverse();
+    testCase(*descending.skip_until_by(10, [](const int& a, const int& b) { return b - a; }) == 8, "skip_until_by, descending");
+
+    // leapfrog intersection of three sorted iterators
+    std::vector<int> a = rusty::range(0, 3000).map([](const int& num) { return num * 2; }).collect<std::vector<int>>();
+    std::vector<int> b = rusty::range(0, 2000).map([](const int& num) { return num * 3; }).collect<std::vector<int>>();
+    std::vector<int> c = { 5, 30, 31, 60, 600, 601, 3600, 5994, 7000 };
+    std::array<decltype(rusty::iter(a)), 3> iters = { rusty::iter(a), rusty::iter(b), rusty::iter(c) };
+    std::vector<int> intersection;
+    const int* current = iters[0].next();
+    size_t matching = 1;
+    for (size_t i = 1; current; i = (i + 1) % 3)
+    {
+        const int* value = iters[i].skip_until_ge(*current);
+        if (!value)
+        {
+            break;
+        }
+
+        if (*value == *current)
+        {
+            if (++matching == 3)
+            {
+                intersection.push_back(*value);
+                value = iters[i].next();
+                matching = 1;
+            }
+        }
+        else
+        {
+            matching = 1;
+        }
+
+        current = value;
+    }
+
+    testCase(intersection == std::vector<int>{ 30, 60, 600, 3600, 5994 }, "skip_until_ge, leapfrog intersection");
+}
+
 void test_min(TestCase& testCase)
 {
     std::vector<int> numbers = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
@@ -1171,6 +2031,267 @@ void test_max_by(TestCase& testCase)
     testCase(!rusty::range(0, 0).max_by([](const int& a, const int& b) { return a - b; }).has_value(), "max_by, empty iterator");
 }
 
+void test_minmax(TestCase& testCase)
+{
+    std::vector<int> numbers = { 5, 1, 9, 3, 7, 2, 8, 6, 4, 0 };
+    testCase(*rusty::iter(numbers).minmax() == std::make_pair(0, 9), "minmax, from vector");
+    testCase(*rusty::iter(numbers).map([](const int& num) { return num; }).minmax() == std::make_pair(0, 9), "minmax, non-contiguous");
+    testCase(*rusty::range(0, 9).minmax() == std::make_pair(0, 8), "minmax, range with odd length");
+    testCase(*rusty::once(3).minmax() == std::make_pair(3, 3), "minmax, single element");
+    testCase(!rusty::range(0, 0).minmax().has_value(), "minmax, empty iterator");
+
+    std::vector<float> floats = { 2.5f, -1.0f, 7.0f, 3.0f };
+    testCase(*rusty::iter(floats).minmax() == std::make_pair(-1.0f, 7.0f), "minmax, floats");
+
+    std::vector<std::pair<int, char>> pairs = { { 2, 'a' }, { 1, 'b' }, { 3, 'c' }, { 1, 'd' }, { 3, 'e' }, { 2, 'f' } };
+    auto compareFirst = [](const std::pair<int, char>& a, const std::pair<int, char>& b) { return a.first - b.first; };
+    auto minmaxPairs = *rusty::iter(pairs).minmax_by(compareFirst);
+    testCase(minmaxPairs.first.second == 'b' && minmaxPairs.second.second == 'c', "minmax_by, returns the first minimum and maximum");
+
+    auto minmaxPairsCopied = *rusty::iter(pairs).map([](const std::pair<int, char>& p) { return p; }).minmax_by(compareFirst);
+    testCase(minmaxPairsCopied.first.second == 'b' && minmaxPairsCopied.second.second == 'c', "minmax_by, non-stable pointers");
+
+    int comparisons = 0;
+    rusty::range(0, 100).minmax_by([&](const int& a, const int& b) { ++comparisons; return a - b; });
+    testCase(comparisons <= 150, "minmax_by, 1.5 comparisons per element");
+
+    testCase(*rusty::iter(numbers).position_min() == std::make_pair(size_t(9), 0), "position_min, from vector");
+    testCase(*rusty::iter(numbers).position_max() == std::make_pair(size_t(2), 9), "position_max, from vector");
+    testCase(*rusty::range(3, 10).position_min() == std::make_pair(size_t(0), 3), "position_min, range");
+    testCase(*rusty::range(3, 10).position_max<int>() == std::make_pair(6, 9), "position_max, range, custom position type");
+    testCase(!rusty::range(0, 0).position_min().has_value(), "position_min, empty iterator");
+
+    std::vector<int> repeated = { 4, 1, 4, 1 };
+    testCase(rusty::iter(repeated).position_min()->first == 1 && rusty::iter(repeated).position_max()->first == 0, "position_min and position_max, first occurrence");
+
+    std::vector<float> withNaN = { 3.0f, std::numeric_limits<float>::quiet_NaN(), 1.0f };
+    testCase(rusty::iter(withNaN).position_min()->first == 2, "position_min, NaN is skipped");
+
+    testCase(rusty::iter(pairs).position_min_by(compareFirst)->first == 1, "position_min_by");
+    testCase(rusty::iter(pairs).position_max_by(compareFirst)->first == 2, "position_max_by");
+}
+
+void test_k_smallest(TestCase& testCase)
+{
+    std::vector<int> numbers = { 5, 1, 9, 3, 7, 2, 8, 6, 4, 0 };
+    testCase(rusty::iter(numbers).k_smallest(3) == std::vector<int>{ 0, 1, 2 }, "k_smallest, from vector");
+    testCase(rusty::iter(numbers).k_smallest(0).empty(), "k_smallest, k is 0");
+    testCase(rusty::iter(numbers).k_smallest(20) == std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }, "k_smallest, k is larger than the iterator");
+    testCase(rusty::range(0, 0).k_smallest(3).empty(), "k_smallest, empty iterator");
+    testCase(rusty::range(0, 1000).map([](const int& num) { return (num * 37) % 1000; }).k_smallest(5) == std::vector<int>{ 0, 1, 2, 3, 4 }, "k_smallest, many elements");
+    testCase(rusty::iter(numbers).k_smallest_by(3, [](const int& a, const int& b) { return b - a; }) == std::vector<int>{ 9, 8, 7 }, "k_smallest_by, reversed");
+
+    std::vector<int> shuffled = rusty::range(0, 500).map([](const int& num) { return (num * 7919) % 101; }).collect<std::vector<int>>();
+    std::vector<int> sortedShuffled = shuffled;
+    std::sort(sortedShuffled.begin(), sortedShuffled.end());
+    testCase(rusty::iter(shuffled).k_smallest(37) == std::vector<int>(sortedShuffled.begin(), sortedShuffled.begin() + 37), "k_smallest, many replacements with duplicates");
+
+    std::vector<std::string> texts = { "hello world", "foo", "test 1234", "a", "bar" };
+    testCase(
+        rusty::iter(texts).k_smallest_by_key(2, [](const std::string& str) { return str.length(); }) == std::vector<std::string>{ "a", "foo" } ||
+        rusty::iter(texts).k_smallest_by_key(2, [](const std::string& str) { return str.length(); }) == std::vector<std::string>{ "a", "bar" },
+        "k_smallest_by_key, string length"
+    );
+
+    testCase(rusty::iter(numbers).k_largest(3) == std::vector<int>{ 9, 8, 7 }, "k_largest, from vector");
+    testCase(rusty::iter(numbers).k_largest_by(2, [](const int& a, const int& b) { return a - b; }) == std::vector<int>{ 9, 8 }, "k_largest_by");
+    testCase(rusty::iter(texts).k_largest_by_key(1, [](const std::string& str) { return str.length(); }) == std::vector<std::string>{ "hello world" }, "k_largest_by_key, string length");
+
+    size_t keyCalls = 0;
+    auto countedKey = [&](const int& num) { ++keyCalls; return -num; };
+    std::vector<int> smallestByKey = rusty::iter(shuffled).k_smallest_by_key(5, countedKey);
+    testCase(smallestByKey == std::vector<int>(sortedShuffled.rbegin(), sortedShuffled.rbegin() + 5) && keyCalls == shuffled.size(), "k_smallest_by_key, key called once per element");
+
+    keyCalls = 0;
+    std::vector<int> largestByKey = rusty::iter(shuffled).k_largest_by_key(5, countedKey);
+    testCase(largestByKey == std::vector<int>(sortedShuffled.begin(), sortedShuffled.begin() + 5) && keyCalls == shuffled.size(), "k_largest_by_key, key called once per element");
+}
+
+void test_select_nth(TestCase& testCase)
+{
+    std::vector<int> numbers = { 5, 1, 9, 3, 7, 2, 8, 6, 4, 0 };
+    testCase(rusty::iter(numbers).select_nth(0) == 0, "select_nth, smallest");
+    testCase(rusty::iter(numbers).select_nth(3) == 3, "select_nth, from vector");
+    testCase(rusty::iter(numbers).select_nth(9) == 9, "select_nth, largest");
+    testCase(!rusty::iter(numbers).select_nth(10).has_value(), "select_nth, index out of range");
+    testCase(rusty::iter(numbers).select_nth_by(0, [](const int& a, const int& b) { return b - a; }) == 9, "select_nth_by, descending");
+
+    testCase(rusty::iter(numbers).median() == 4, "median, even number of elements");
+    testCase(rusty::range(0, 7).reverse().median() == 3, "median, odd number of elements");
+    testCase(!rusty::range(0, 0).median().has_value(), "median, empty iterator");
+    testCase(rusty::iter(numbers).median_by([](const int& a, const int& b) { return b - a; }) == 5, "median_by, descending");
+
+    std::vector<int> shuffled = rusty::range(0, 101).map([](const int& num) { return (num * 37) % 101; }).collect<std::vector<int>>();
+    testCase(rusty::iter(shuffled).quantiles({ 0.5, 0.0, 0.99, 1.0, 0.25 }) == std::vector<int>{ 50, 0, 99, 100, 25 }, "quantiles, from vector");
+    testCase(rusty::iter(shuffled).quantiles({ 0.9, 0.9, -1.0, 2.0 }) == std::vector<int>{ 90, 90, 0, 100 }, "quantiles, duplicate and clamped quantiles");
+    testCase(rusty::iter(shuffled).quantiles({ }).empty(), "quantiles, no quantiles");
+    testCase(rusty::iter(shuffled).quantiles({ std::numeric_limits<double>::quiet_NaN(), 1.0 }) == std::vector<int>{ 0, 100 }, "quantiles, NaN is treated as 0");
+    testCase(rusty::range(0, 0).quantiles({ 0.5 }).empty(), "quantiles, empty iterator");
+    testCase(rusty::iter(shuffled).quantiles_by({ 0.0, 0.1 }, [](const int& a, const int& b) { return b - a; }) == std::vector<int>{ 100, 90 }, "quantiles_by, descending");
+
+    std::vector<double> quantiles = rusty::range(0, 21).map([](const int& num) { return num / 20.0; }).collect<std::vector<double>>();
+    std::vector<int> expected = rusty::iter(quantiles).map([](const double& q) { return static_cast<int>(q * 100); }).collect<std::vector<int>>();
+    testCase(rusty::iter(shuffled).quantiles(quantiles) == expected, "quantiles, many quantiles");
+}
+
+void test_approx_quantiles(TestCase& testCase)
+{
+    std::vector<int> numbers = { 5, 1, 9, 3, 7, 2, 8, 6, 4, 0 };
+    rusty::QuantileSketch<int> small = rusty::iter(numbers).approx_quantiles(0.01);
+    testCase(small.count() == 10 && small.quantiles({ 0.0, 0.5, 1.0 }) == std::vector<int>{ 0, 4, 9 }, "approx_quantiles, exact for few elements");
+    testCase(!rusty::range(0, 0).approx_quantiles(0.01).quantile(0.5).has_value(), "approx_quantiles, empty iterator");
+
+    static constexpr int count = 100000;
+    auto shuffled = []() { return rusty::range(0, count).map([](const int& num) { return static_cast<int>((num * 7919ll) % count); }); };
+    auto isAccurate = [](const rusty::QuantileSketch<int>& sketch, double epsilon)
+    {
+        return rusty::iter(std::vector<double>{ 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99 }).all([&](const double& q)
+        {
+            int expected = static_cast<int>(q * (count - 1));
+            int actual = *sketch.quantile(q);
+            return std::abs(actual - expected) <= epsilon * count;
+        });
+    };
+
+    rusty::QuantileSketch<int> sketch = shuffled().approx_quantiles(0.01);
+    testCase(sketch.count() == count, "approx_quantiles, count");
+    testCase(sketch.retained() < 1000, "approx_quantiles, bounded memory");
+    testCase(sketch.quantile(0.0) == 0 && sketch.quantile(1.0) == count - 1, "approx_quantiles, exact min and max");
+    testCase(isAccurate(sketch, 0.01), "approx_quantiles, accuracy");
+
+    rusty::QuantileSketch<int> merged = shuffled().take(count / 2).approx_quantiles(0.01);
+    merged.merge(shuffled().skip(count / 2).approx_quantiles(0.01));
+    testCase(merged.count() == count && merged.retained() < 1000, "approx_quantiles, merged count");
+    testCase(isAccurate(merged, 0.01), "approx_quantiles, merged accuracy");
+
+    rusty::QuantileSketch<int> doubled = shuffled().approx_quantiles(0.01);
+    doubled.merge(doubled);
+    testCase(doubled.count() == 2 * count && doubled.retained() < 1000 && isAccurate(doubled, 0.01), "approx_quantiles, merged with itself");
+    testCase(sketch.quantile(std::numeric_limits<double>::quiet_NaN()) == 0 && sketch.quantile(2.0) == count - 1, "approx_quantiles, NaN and clamped quantiles");
+}
+
+void test_approx_count_distinct(TestCase& testCase)
+{
+    auto isClose = [](size_t estimate, size_t expected, double relativeError)
+    {
+        return std::abs(static_cast<double>(estimate) - static_cast<double>(expected)) <= relativeError * static_cast<double>(expected);
+    };
+
+    testCase(rusty::range(0, 0).approx_count_distinct().estimate() == 0 && rusty::range(0, 0).approx_count_distinct().empty(), "approx_count_distinct, empty iterator");
+    testCase(rusty::range(0, 10).cycle().take(100).approx_count_distinct().estimate() == 10, "approx_count_distinct, few distinct elements");
+
+    rusty::DistinctCountSketch<int> sketch = rusty::range(0, 200000).map([](const int& num) { return num / 2; }).approx_count_distinct(14);
+    testCase(isClose(sketch.estimate(), 100000, 0.03), "approx_count_distinct, many distinct elements");
+
+    std::vector<std::string> texts = rusty::range(0, 5000).map([](const int& num) { return std::to_string(num % 3000); }).collect<std::vector<std::string>>();
+    testCase(isClose(rusty::iter(texts).approx_count_distinct(12).estimate(), 3000, 0.06), "approx_count_distinct, strings");
+
+    rusty::DistinctCountSketch<int> merged = rusty::range(0, 60000).approx_count_distinct(14);
+    merged.merge(rusty::range(40000, 100000).approx_count_distinct(14));
+    testCase(isClose(merged.estimate(), 100000, 0.03), "approx_count_distinct, merged overlapping sketches");
+
+    rusty::DistinctCountSketch<int> lowPrecision = rusty::range(0, 60000).approx_count_distinct(10);
+    lowPrecision.merge(rusty::range(40000, 100000).approx_count_distinct(14));
+    testCase(lowPrecision.precision() == 10 && isClose(lowPrecision.estimate(), 100000, 0.1), "approx_count_distinct, merged sketches with different precisions");
+}
+
+void test_stats(TestCase& testCase)
+{
+    auto isClose = [](double a, double b) { return std::abs(a - b) <= 1e-9 * (std::abs(b) + 1.0); };
+
+    std::vector<int> numbers = { 2, 4, 4, 4, 5, 5, 7, 9 };
+    rusty::Statistics<int> stats = rusty::iter(numbers).stats();
+    testCase(stats.count() == 8 && stats.min() == 2 && stats.max() == 9, "stats, count, min and max");
+    testCase(isClose(stats.mean(), 5.0) && isClose(stats.variance(), 4.0) && isClose(stats.stddev(), 2.0), "stats, mean and variance");
+    testCase(isClose(stats.sample_variance(), 32.0 / 7.0), "stats, sample variance");
+
+    rusty::Statistics<int> fromList = rusty::iter(std::list<int>(numbers.begin(), numbers.end())).stats();
+    testCase(fromList.count() == 8 && isClose(fromList.mean(), 5.0) && isClose(fromList.variance(), 4.0), "stats, from non-contiguous collection");
+
+    rusty::Statistics<int> empty = rusty::range(0, 0).stats();
+    testCase(empty.empty() && !empty.min().has_value() && empty.mean() == 0.0 && empty.variance() == 0.0, "stats, empty iterator");
+
+    // values with a large offset, where the naive sum of squares formula loses all precision
+    std::vector<double> offset = rusty::range(0, 1000).map([](const int& num) { return 1e9 + (num % 2); }).collect<std::vector<double>>();
+    rusty::Statistics<double> offsetStats = rusty::iter(offset).stats();
+    testCase(isClose(offsetStats.mean(), 1e9 + 0.5) && std::abs(offsetStats.variance() - 0.25) < 1e-6, "stats, numerically stable");
+
+    rusty::Statistics<double> offsetStatsWelford = rusty::iter(offset).map([](const double& num) { return num; }).stats();
+    testCase(isClose(offsetStatsWelford.mean(), 1e9 + 0.5) && std::abs(offsetStatsWelford.variance() - 0.25) < 1e-6, "stats, numerically stable without blocks");
+
+    std::vector<int> many = rusty::range(0, 1000).map([](const int& num) { return (num * 37) % 101; }).collect<std::vector<int>>();
+    rusty::Statistics<int> blocked = rusty::iter(many).stats();
+    rusty::Statistics<int> sequential = rusty::iter(many).filter([](const int&) { return true; }).stats();
+    testCase(blocked.count() == sequential.count() && isClose(blocked.mean(), sequential.mean()) && isClose(blocked.variance(), sequential.variance())
+        && blocked.min() == sequential.min() && blocked.max() == sequential.max(), "stats, blocked and sequential are the same");
+
+    rusty::Statistics<int> merged = rusty::iter(many).take(300).stats();
+    merged.merge(rusty::iter(many).skip(300).stats());
+    merged.merge(rusty::Statistics<int>());
+    testCase(merged.count() == 1000 && isClose(merged.mean(), sequential.mean()) && isClose(merged.variance(), sequential.variance())
+        && merged.min() == sequential.min() && merged.max() == sequential.max(), "stats, merged");
+}
+
+void test_heavy_hitters(TestCase& testCase)
+{
+    std::vector<std::string> words = { "a", "b", "a", "c", "a", "b", "d", "a" };
+    auto top = rusty::iter(words).heavy_hitters(3).top();
+    testCase(top.size() == 3 && top[0].value == "a" && top[0].count == 4 && top[0].error == 0, "heavy_hitters, most frequent element");
+    testCase(rusty::iter(words).heavy_hitters(10).top().size() == 4, "heavy_hitters, less distinct elements than capacity");
+    testCase(rusty::iter(words).heavy_hitters(0).top().empty(), "heavy_hitters, zero capacity");
+    testCase(rusty::range(0, 0).heavy_hitters(3).total() == 0, "heavy_hitters, empty iterator");
+
+    // a few frequent values mixed into lots of rare ones
+    auto stream = [](int start, int end)
+    {
+        return rusty::range(start, end).map([](const int& num) { return num % 4 == 0 ? num % 12 : 1000 + num; });
+    };
+
+    auto frequentValues = [](const rusty::HeavyHittersSketch<int>& sketch)
+    {
+        auto top = sketch.top();
+        std::vector<int> values = rusty::iter(top).take(3).map([](const rusty::HeavyHittersSketch<int>::Item& item) { return item.value; }).collect<std::vector<int>>();
+        std::sort(values.begin(), values.end());
+        return values;
+    };
+
+    auto boundsAreValid = [](const rusty::HeavyHittersSketch<int>& sketch, size_t realCount)
+    {
+        auto top = sketch.top();
+        return rusty::iter(top).take(3).all([&](const rusty::HeavyHittersSketch<int>::Item& item) { return item.count >= realCount && item.count - item.error <= realCount; });
+    };
+
+    rusty::HeavyHittersSketch<int> sketch = stream(0, 30000).heavy_hitters(20);
+    testCase(sketch.total() == 30000 && sketch.top().size() == 20, "heavy_hitters, total and capacity");
+    testCase(frequentValues(sketch) == std::vector<int>{ 0, 4, 8 } && boundsAreValid(sketch, 2500), "heavy_hitters, frequent elements among rare ones");
+
+    rusty::HeavyHittersSketch<int> merged = stream(0, 15000).heavy_hitters(20);
+    merged.merge(stream(15000, 30000).heavy_hitters(20));
+    testCase(merged.total() == 30000 && merged.top().size() == 20, "heavy_hitters, merged total and capacity");
+    testCase(frequentValues(merged) == std::vector<int>{ 0, 4, 8 } && boundsAreValid(merged, 2500), "heavy_hitters, merged frequent elements");
+}
+
+void test_counts(TestCase& testCase)
+{
+    std::vector<std::string> words = { "b", "a", "b", "c", "a", "b" };
+    testCase(rusty::iter(words).counts() == std::vector<std::pair<std::string, size_t>>{ { "b", 3 }, { "a", 2 }, { "c", 1 } }, "counts, from vector");
+    testCase(rusty::range(0, 0).counts().empty(), "counts, empty iterator");
+    testCase(rusty::range(0, 10).counts_by([](const int& num) { return num % 3 == 0; }) == std::vector<std::pair<bool, size_t>>{ { true, 4 }, { false, 6 } }, "counts_by, bool key");
+
+    auto manyCounts = rusty::range(0, 100000).map([](const int& num) { return (num * 7919) % 1000; }).counts();
+    testCase(manyCounts.size() == 1000 && rusty::iter(manyCounts).all([](const std::pair<int, size_t>& entry) { return entry.second == 100; }), "counts, many distinct elements");
+
+    std::vector<int> latencies = { 0, 3, 5, 9, 10, 12, 19, 20, 25, -1 };
+    testCase(rusty::iter(latencies).histogram(0, 20, 4) == std::vector<size_t>{ 2, 2, 2, 1 }, "histogram, from vector");
+    testCase(rusty::range(0, 10).histogram(0, 10, 10) == std::vector<size_t>(10, 1), "histogram, one bin per value");
+    testCase(rusty::iter(std::vector<double>{ 0.1, 0.2, 0.3, 0.7, 0.99 }).histogram(0.0, 1.0, 2) == std::vector<size_t>{ 3, 2 }, "histogram, floating point values");
+    testCase(rusty::range(0, 10).histogram(0, 10, 0).empty() && rusty::range(0, 10).histogram(5, 5, 3).empty(), "histogram, invalid bins");
+
+    auto invalidBinsIter = rusty::range(0, 10);
+    bool invalidBinsEmpty = invalidBinsIter.histogram(0, 10, 0).empty();
+    testCase(invalidBinsEmpty && !invalidBinsIter.next(), "histogram, invalid bins consume the iterator");
+}
+
 void test_sum(TestCase& testCase)
 {
     std::vector<int> numbers = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
@@ -1511,6 +2632,13 @@ void test_compiler_error_messages()
         rusty::range(0, 10).position([](int&) { return true; });
         rusty::range(0, 10).min_by([](int&, int&) { return 0; });
         rusty::range(0, 10).max_by([](int&, int&) { return 0; });
+        rusty::range(0, 10).k_smallest_by(3, [](int&, int&) { return 0; });
+        rusty::range(0, 10).select_nth_by(3, [](int&, int&) { return 0; });
+        rusty::range(0, 10).quantiles_by({ 0.5 }, [](int&, int&) { return 0; });
+        rusty::range(0, 10).median_by([](int&, int&) { return 0; });
+        rusty::range(0, 10).counts_by([](int&) { return 0; });
+        rusty::range(0, 10).minmax_by([](int&, int&) { return 0; });
+        rusty::range(0, 10).position_min_by([](int&, int&) { return 0; });
         rusty::range(0, 10).is_sorted_by([](int&, int&) { return 0; });
         rusty::range(0, 10).cmp_by(rusty::range(0, 10), [](int&, int&) { return 0; });
         rusty::range(0, 10).eq_by(rusty::range(0, 10), [](int&, int&) { return 0; });
@@ -1521,6 +2649,19 @@ void test_compiler_error_messages()
         rusty::range(0, 10).skip_while([](int&) { return true; });
         rusty::range(0, 10).take_while([](int&) { return true; });
         rusty::range(0, 10).inspect([](int&) { });
+        rusty::range(0, 10).chunk_by([](int&) { return 0; });
+        rusty::range(0, 10).dedup_by([](int&, int&) { return true; });
+        rusty::range(0, 10).dedup_by_key([](int&) { return 0; });
+        rusty::range(0, 10).unique_by([](int&) { return 0; });
+        rusty::range(0, 10).map_while([](int&) { return std::optional<int>(); });
+        rusty::range(0, 10).merge_by(rusty::range(0, 10), [](int&, int&) { return 0; });
+        rusty::range(0, 10).hash_join(rusty::range(0, 10), [](int&) { return 0; }, [](const int&) { return 0; });
+        rusty::range(0, 10).merge_join(rusty::range(0, 10), [](int&, int&) { return 0; });
+        rusty::range(0, 10).intersect_by(rusty::range(0, 10), [](int&, int&) { return 0; });
+        rusty::range(0, 10).partition_point([](int&) { return true; });
+        rusty::range(0, 10).binary_search_by([](int&) { return 0; });
+        rusty::range(0, 10).skip_until_by(5, [](int&, int&) { return 0; });
+        rusty::range(0, 10).sorted_lazy_by([](int&, int&) { return 0; });
 
         // TODO: better error message for this? we need to detect if the callback returns an std::optional
         rusty::range(0, 10).filter_map([](const int& value) { return value; });
@@ -1561,6 +2702,22 @@ int main()
         test_flatten(testCase);
         test_inspect(testCase);
         test_cycle(testCase);
+        test_chunks(testCase);
+        test_windows(testCase);
+        test_rolling(testCase);
+        test_array_chunks(testCase);
+        test_chunk_by(testCase);
+        test_dedup(testCase);
+        test_unique(testCase);
+        test_map_while(testCase);
+        test_fuse(testCase);
+        test_combinatorics(testCase);
+        test_tee(testCase);
+        test_merge(testCase);
+        test_interleave(testCase);
+        test_join(testCase);
+        test_set_operations(testCase);
+        test_sorted_lazy(testCase);
 
         test_collect(testCase);
         test_partition(testCase);
@@ -1573,10 +2730,20 @@ int main()
         test_any(testCase);
         test_find(testCase);
         test_position(testCase);
+        test_binary_search(testCase);
+        test_skip_until(testCase);
         test_min(testCase);
         test_min_by(testCase);
         test_max(testCase);
         test_max_by(testCase);
+        test_minmax(testCase);
+        test_k_smallest(testCase);
+        test_select_nth(testCase);
+        test_approx_quantiles(testCase);
+        test_approx_count_distinct(testCase);
+        test_stats(testCase);
+        test_heavy_hitters(testCase);
+        test_counts(testCase);
         test_sum(testCase);
         test_product(testCase);
         test_is_sorted_ascending(testCase);